@@ -0,0 +1,183 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Account_Report
+{
+	// Where a BankAccount tells us what it did. Writing every line to cout with endl
+	// flushes the console for every deposit, which soon costs more than the deposit.
+	// The account holds a pointer to its report, the choices are:
+	// - nullptr, reports nothing, all it costs is checking the pointer
+	// - ConsoleReport, a line at a time, flushed, the way it always worked
+	// - TextReport, the same lines gathered up and written in big blocks
+	// - BinaryReport, fixed size records gathered up and written in big blocks
+	// None of them are thread safe, LockedReport lets several threads share one
+
+	struct Report
+	{
+		virtual ~Report() = default;
+		virtual void deposited(std::uint32_t account, int amount, int balance) = 0;
+		virtual void withdrew(std::uint32_t account, int amount, int balance) = 0;
+		virtual void flush() {} // write out anything held back
+	};
+
+	class ConsoleReport : public Report
+	{
+		std::ostream& os;
+	public:
+		explicit ConsoleReport(std::ostream& os)
+			: os{os}
+		{
+		}
+
+		void deposited(std::uint32_t, int amount, int balance) override
+		{
+			os << "deposited " << amount << ", balance now " << balance << std::endl;
+		}
+
+		void withdrew(std::uint32_t, int amount, int balance) override
+		{
+			os << "withdrew " << amount << ", balance now " << balance << std::endl;
+		}
+	};
+
+	// What every account reports to unless told otherwise
+	inline ConsoleReport& console()
+	{
+		static ConsoleReport report{ std::cout };
+		return report;
+	}
+
+	class TextReport : public Report
+	{
+		std::ostream& os;
+		std::string buffer;
+		const std::size_t capacity;
+
+		void line(const char* what, int amount, int balance)
+		{
+			buffer += what;
+			buffer += std::to_string(amount);
+			buffer += ", balance now ";
+			buffer += std::to_string(balance);
+			buffer += '\n';
+			if(buffer.size() >= capacity)
+				flush();
+		}
+	public:
+		explicit TextReport(std::ostream& os, std::size_t capacity = 64 * 1024)
+			: os{os},
+			  capacity{capacity}
+		{
+			buffer.reserve(capacity + 64);
+		}
+
+		~TextReport()
+		{
+			flush();
+		}
+
+		void flush() override
+		{
+			os.write(buffer.data(), buffer.size());
+			buffer.clear();
+		}
+
+		void deposited(std::uint32_t, int amount, int balance) override
+		{
+			line("deposited ", amount, balance);
+		}
+
+		void withdrew(std::uint32_t, int amount, int balance) override
+		{
+			line("withdrew ", amount, balance);
+		}
+	};
+
+	class BinaryReport : public Report
+	{
+	public:
+		struct Entry
+		{
+			std::uint32_t account;
+			std::uint8_t withdrawal; // 0 for a deposit
+			std::uint8_t unused[3];
+			std::int32_t amount;
+			std::int32_t balance;
+		};
+		static_assert(sizeof(Entry) == 16, "entries are written out as is");
+
+	private:
+		std::ostream& os;
+		std::vector<Entry> buffer;
+		const std::size_t capacity;
+
+		void add(std::uint32_t account, bool withdrawal, int amount, int balance)
+		{
+			buffer.push_back({ account, static_cast<std::uint8_t>(withdrawal), {}, amount, balance });
+			if(buffer.size() == capacity)
+				flush();
+		}
+	public:
+		explicit BinaryReport(std::ostream& os, std::size_t capacity = 4096) // in entries
+			: os{os},
+			  capacity{capacity}
+		{
+			buffer.reserve(capacity);
+		}
+
+		~BinaryReport()
+		{
+			flush();
+		}
+
+		void flush() override
+		{
+			os.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(Entry));
+			buffer.clear();
+		}
+
+		void deposited(std::uint32_t account, int amount, int balance) override
+		{
+			add(account, false, amount, balance);
+		}
+
+		void withdrew(std::uint32_t account, int amount, int balance) override
+		{
+			add(account, true, amount, balance);
+		}
+	};
+
+	// Passes everything on to another report, one thread at a time
+	class LockedReport : public Report
+	{
+		Report& report;
+		std::mutex mtx;
+	public:
+		explicit LockedReport(Report& report)
+			: report{report}
+		{
+		}
+
+		void deposited(std::uint32_t account, int amount, int balance) override
+		{
+			std::lock_guard<std::mutex> lock{ mtx };
+			report.deposited(account, amount, balance);
+		}
+
+		void withdrew(std::uint32_t account, int amount, int balance) override
+		{
+			std::lock_guard<std::mutex> lock{ mtx };
+			report.withdrew(account, amount, balance);
+		}
+
+		void flush() override
+		{
+			std::lock_guard<std::mutex> lock{ mtx };
+			report.flush();
+		}
+	};
+}
@@ -1,7 +1,23 @@
+#define _SCL_SECURE_NO_WARNINGS // boost compile errors
 #include <iostream>
+#include <fstream>
+#include <string>
 #include <vector>
 #include <algorithm>
+#include <random>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <memory>
+#include <mutex>
+#include <thread>
 using namespace std;
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include "ShardedRouter.h"
+#include "AccountReport.h"
 
 namespace CommandPattern
 {
@@ -17,13 +33,16 @@ namespace CommandPattern
 
 	struct BankAccount
 	{
+		uint32_t id = 0; // So a command can be written down without the reference
 		int balance = 0;
 		int overdraft_limit = -500;
+		Account_Report::Report* report = &Account_Report::console(); // nullptr to say nothing
 
 		void deposit(int amount)
 		{
 			balance += amount;
-			cout << "deposited " << amount << ", balance now " << balance << endl;
+			if(report)
+				report->deposited(id, amount, balance);
 		}
 
 		void withdraw(int amount)
@@ -31,7 +50,8 @@ namespace CommandPattern
 			if(balance - amount >= overdraft_limit)
 			{
 				balance -= amount;
-				cout << "withdrew " << amount << ", balance now " << balance << endl;
+				if(report)
+					report->withdrew(id, amount, balance);
 			}
 		}
 	};
@@ -81,6 +101,282 @@ namespace CommandPattern
 		}
 	};
 
+	// As commands are just data we can write them down as they happen, and
+	// play them back later to get the accounts back to where they were.
+	// The journal is a set of segment files, each a header then fixed size records
+
+	struct JournalRecord
+	{
+		uint32_t account;
+		uint8_t action; // a Command::Action
+		uint8_t unused[3];
+		int32_t amount;
+	};
+	static_assert(sizeof(JournalRecord) == 12, "journal records are written to disk as is");
+
+	struct JournalHeader
+	{
+		char magic[8];
+		uint32_t record_size;
+		uint32_t unused;
+		uint64_t committed; // records before this are safe, anything after was never committed
+	};
+
+	// When a commit waits for the records to reach the disk
+	enum class FsyncPolicy
+	{
+		None,  // never, the OS writes them back in its own time
+		Async, // starts writing them back, doesn't wait
+		Sync   // waits until they are on the disk
+	};
+
+	struct JournalOptions
+	{
+		size_t segment_records = 1 << 20; // records per segment file
+		size_t group_size = 256;          // records that are committed together
+		FsyncPolicy fsync = FsyncPolicy::Async;
+	};
+
+	class CommandJournal
+	{
+		string path;
+		JournalOptions options;
+		size_t segment = 0;
+		boost::interprocess::file_mapping file;
+		boost::interprocess::mapped_region region;
+		JournalHeader* header = nullptr;
+		JournalRecord* records = nullptr;
+		size_t capacity = 0; // records this segment has room for
+		size_t used = 0;     // appended to this segment, committed or not
+
+		static size_t segment_bytes(size_t records)
+		{
+			return sizeof(JournalHeader) + records * sizeof(JournalRecord);
+		}
+
+		static bool exists(const string& file_path)
+		{
+			return ifstream{ file_path }.good();
+		}
+
+		void open_segment(size_t n)
+		{
+			// A segment too short to hold its header and a record was torn while it was being
+			// made, the file created but not yet sized. Nothing in it was committed, so it's made again
+			const auto file_path = segment_path(path, n);
+			auto fresh = file_size(file_path) < segment_bytes(1);
+			if(fresh)
+			{	// The mapping can't grow the file, so it's made full size up front
+				filebuf fb;
+				fb.open(file_path, ios::out | ios::binary | ios::trunc);
+				fb.pubseekoff(segment_bytes(options.segment_records) - 1, ios::beg);
+				fb.sputc(0);
+			}
+
+			using namespace boost::interprocess;
+			file = file_mapping{ file_path.c_str(), read_write };
+			region = mapped_region{ file, read_write };
+			header = static_cast<JournalHeader*>(region.get_address());
+			records = reinterpret_cast<JournalRecord*>(header + 1);
+			segment = n;
+
+			// Or torn after it was sized, before its header was written
+			const char unwritten[sizeof header->magic]{};
+			if(memcmp(header->magic, unwritten, sizeof unwritten) == 0 && header->committed == 0)
+				fresh = true;
+			if(fresh)
+			{
+				memcpy(header->magic, "CMDJRNL1", sizeof header->magic);
+				header->record_size = sizeof(JournalRecord);
+				header->committed = 0;
+			}
+			else if(memcmp(header->magic, "CMDJRNL1", sizeof header->magic) != 0 || header->record_size != sizeof(JournalRecord))
+			{	// Not ours, so rather than write over it
+				region = mapped_region{};
+				throw runtime_error{ file_path + " is not a command journal segment" };
+			}
+
+			// An existing segment keeps its own size, whatever the options say now
+			capacity = (region.get_size() - sizeof(JournalHeader)) / sizeof(JournalRecord);
+			if(header->committed > capacity)
+				header->committed = capacity; // can't have committed more than fits, keep what does
+			used = static_cast<size_t>(header->committed);
+		}
+
+		void flush(size_t offset, size_t bytes)
+		{
+			if(options.fsync != FsyncPolicy::None)
+				region.flush(offset, bytes, options.fsync == FsyncPolicy::Async);
+		}
+	public:
+		// Carries on from the end of an existing journal, if there is one
+		explicit CommandJournal(const string& path, JournalOptions options = {})
+			: path{path},
+			  options{options}
+		{
+			this->options.segment_records = max<size_t>(1, options.segment_records);
+			size_t last = 0;
+			while(exists(segment_path(path, last + 1)))
+				++last;
+			open_segment(last);
+		}
+
+		~CommandJournal()
+		{
+			commit();
+		}
+
+		CommandJournal(const CommandJournal&) = delete;
+		CommandJournal& operator=(const CommandJournal&) = delete;
+
+		static string segment_path(const string& path, size_t n)
+		{
+			return path + "." + to_string(n);
+		}
+
+		// 0 if there is no such file
+		static uint64_t file_size(const string& file_path)
+		{
+			ifstream ifs{ file_path, ios::binary | ios::ate };
+			return ifs ? static_cast<uint64_t>(ifs.tellg()) : 0;
+		}
+
+		static void remove(const string& path)
+		{
+			for(size_t n = 0; exists(segment_path(path, n)); ++n)
+				std::remove(segment_path(path, n).c_str());
+		}
+
+		void append(const Command& cmd)
+		{
+			if(used == capacity)
+			{
+				commit();
+				open_segment(segment + 1);
+			}
+			auto& r = records[used++];
+			r.account = cmd.account.id;
+			r.action = static_cast<uint8_t>(cmd.action);
+			r.amount = cmd.amount;
+
+			// Group commit, one header update and one flush for many records
+			if(used - header->committed >= options.group_size)
+				commit();
+		}
+
+		void commit()
+		{
+			const auto from = static_cast<size_t>(header->committed);
+			if(from == used)
+				return;
+			// The records go first, so the header never says records are committed before they are.
+			// Only Sync waits for each, Async just asks for them in this order
+			flush(segment_bytes(from), (used - from) * sizeof(JournalRecord));
+			header->committed = used;
+			flush(0, sizeof(JournalHeader));
+		}
+	};
+
+	// Rebuilds account_count accounts from the start of a journal, accounts[i] has the id i.
+	// Stops at anything that doesn't look right, everything after it can't be trusted either
+	vector<BankAccount> replay(const string& path, size_t account_count)
+	{
+		using namespace boost::interprocess;
+		vector<BankAccount> accounts(account_count);
+		for(uint32_t i = 0; i < account_count; ++i)
+		{
+			accounts[i].id = i;
+			accounts[i].report = nullptr;
+		}
+
+		for(size_t n = 0; ifstream{ CommandJournal::segment_path(path, n) }.good(); ++n)
+		{
+			// A segment torn before it was sized can't be mapped, and is where the journal ends
+			if(CommandJournal::file_size(CommandJournal::segment_path(path, n)) < sizeof(JournalHeader))
+				return accounts;
+			const file_mapping file{ CommandJournal::segment_path(path, n).c_str(), read_only };
+			const mapped_region region{ file, read_only };
+			const auto header = static_cast<const JournalHeader*>(region.get_address());
+			if(memcmp(header->magic, "CMDJRNL1", sizeof header->magic) != 0 || header->record_size != sizeof(JournalRecord))
+				return accounts; // not a journal we understand
+			if(header->committed > (region.get_size() - sizeof(JournalHeader)) / sizeof(JournalRecord))
+				return accounts; // says it has more records than fit in the file
+
+			const auto records = reinterpret_cast<const JournalRecord*>(header + 1);
+			for(uint64_t i = 0; i < header->committed; ++i)
+			{
+				const auto& r = records[i];
+				if(r.account >= account_count || r.action > Command::withdraw)
+					return accounts;
+				Command{ accounts[r.account], static_cast<Command::Action>(r.action), r.amount }.call();
+			}
+		}
+		return accounts;
+	}
+
+	// Lots of threads issuing commands against the same accounts would need a lock per account.
+	// Instead each account belongs to one shard (id % shards) and only that shard's thread ever
+	// touches it. Commands are sent to the shard as records through a ShardedRouter, lock free
+	// single producer queues, one per producer per shard, so a producer's commands for an account stay in order
+	class CommandRouter
+	{
+		// accounts[i] has the id i * shard_count + this shard
+		struct Shard
+		{
+			vector<BankAccount> accounts;
+			size_t shard_count;
+
+			void operator()(const JournalRecord* records, size_t n)
+			{
+				for(size_t i = 0; i < n; ++i)
+				{
+					const auto& r = records[i];
+					Command{ accounts[r.account / shard_count], static_cast<Command::Action>(r.action), r.amount }.call();
+				}
+			}
+		};
+
+		const size_t account_count;
+		Sharded_Router::ShardedRouter<JournalRecord, Shard> router;
+	public:
+		CommandRouter(size_t account_count, size_t producers, size_t shard_count, size_t queue_capacity = 4096) // rounded up to a power of two
+			: account_count{account_count},
+			  router{ producers, shard_count, [&](size_t s)
+			  {
+				  Shard shard{ {}, shard_count };
+				  for(auto id = s; id < account_count; id += shard_count)
+				  {
+					  shard.accounts.emplace_back();
+					  shard.accounts.back().id = static_cast<uint32_t>(id);
+					  shard.accounts.back().report = nullptr;
+				  }
+				  return shard;
+			  }, queue_capacity }
+		{
+		}
+
+		// Only ever called by producer number `producer`'s own thread.
+		// False if there's no such account
+		bool post(size_t producer, uint32_t account, Command::Action action, int amount)
+		{
+			if(account >= account_count)
+				return false;
+			router.post(producer, account, JournalRecord{ account, static_cast<uint8_t>(action), {}, amount });
+			return true;
+		}
+
+		// Call once the producers have finished, everything they posted is executed before this returns
+		void stop()
+		{
+			router.stop();
+		}
+
+		// Only once stopped
+		const BankAccount& account(uint32_t id) const
+		{
+			return router.worker(id % router.shard_count()).accounts[id / router.shard_count()];
+		}
+	};
 }
 
 using namespace CommandPattern;
@@ -111,4 +407,200 @@ int CommandPattern_main(int argc, char* argv[])
 
 	getchar();
 	return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
+
+// Journal lots of commands, then replay them and check we end up with the same balances
+int CommandPattern_Journal_main(int argc, char* argv[])
+{
+	const string path = "commands.journal";
+	const size_t account_count = 1000;
+	const size_t command_count = 4000000;
+
+	mt19937 rng{ 42 };
+	uniform_int_distribution<uint32_t> which{ 0, account_count - 1 };
+	uniform_int_distribution<int> amount{ 1, 300 };
+	bernoulli_distribution deposit{ 0.5 };
+
+	for(auto fsync : { FsyncPolicy::None, FsyncPolicy::Async, FsyncPolicy::Sync })
+	{
+		CommandJournal::remove(path);
+		vector<BankAccount> accounts(account_count);
+		for(uint32_t i = 0; i < account_count; ++i)
+		{
+			accounts[i].id = i;
+			accounts[i].report = nullptr;
+		}
+
+		// Syncing every group is slow, so it gets fewer commands
+		const auto count = fsync == FsyncPolicy::Sync ? command_count / 16 : command_count;
+		const auto start = chrono::steady_clock::now();
+		{
+			JournalOptions options;
+			options.fsync = fsync;
+			CommandJournal journal{ path, options };
+			for(size_t i = 0; i < count; ++i)
+			{
+				const Command cmd{ accounts[which(rng)], deposit(rng) ? Command::deposit : Command::withdraw, amount(rng) };
+				cmd.call();
+				journal.append(cmd);
+			}
+		}
+		const chrono::duration<double> written = chrono::steady_clock::now() - start;
+
+		const auto replay_start = chrono::steady_clock::now();
+		const auto replayed = replay(path, account_count);
+		const chrono::duration<double> replay_time = chrono::steady_clock::now() - replay_start;
+
+		bool same = replayed.size() == accounts.size();
+		for(size_t i = 0; same && i < accounts.size(); ++i)
+			same = replayed[i].balance == accounts[i].balance;
+
+		const char* names[]{ "none", "async", "sync" };
+		cout << "fsync " << names[static_cast<int>(fsync)] << ": "
+			 << count / written.count() / 1e6 << "M commands/sec journaled, "
+			 << count / replay_time.count() / 1e6 << "M commands/sec replayed, "
+			 << (same ? "balances match" : "balances differ!") << endl;
+	}
+	CommandJournal::remove(path);
+
+	getchar();
+	return EXIT_SUCCESS;
+}
+
+// Several threads issuing commands, through one lock against through the sharded router
+int CommandPattern_Router_main(int argc, char* argv[])
+{
+	const uint32_t account_count = 10000;
+	const size_t per_producer = 1000000;
+	const size_t producers = max(2u, thread::hardware_concurrency() / 2);
+	const size_t shard_count = producers;
+
+	// Each producer only uses the accounts id % producers == its number, so the
+	// balances don't depend on how the producers happen to interleave
+	const auto workload = [&](size_t producer, auto issue)
+	{
+		mt19937 rng{ static_cast<unsigned>(producer) };
+		uniform_int_distribution<uint32_t> which{ 0, account_count / static_cast<uint32_t>(producers) - 1 };
+		uniform_int_distribution<int> amount{ 1, 300 };
+		bernoulli_distribution deposit{ 0.5 };
+		for(size_t i = 0; i < per_producer; ++i)
+		{
+			const auto id = which(rng) * static_cast<uint32_t>(producers) + static_cast<uint32_t>(producer);
+			issue(id, deposit(rng) ? Command::deposit : Command::withdraw, amount(rng));
+		}
+	};
+	const auto run_producers = [&](auto issue_from)
+	{
+		const auto start = chrono::steady_clock::now();
+		vector<thread> threads;
+		for(size_t p = 0; p < producers; ++p)
+			threads.emplace_back([&, p] { workload(p, issue_from(p)); });
+		for(auto& t : threads)
+			t.join();
+		return chrono::steady_clock::now() - start;
+	};
+
+	vector<BankAccount> locked_accounts(account_count);
+	for(uint32_t i = 0; i < account_count; ++i)
+	{
+		locked_accounts[i].id = i;
+		locked_accounts[i].report = nullptr;
+	}
+	mutex mtx;
+	const chrono::duration<double> locked = run_producers([&](size_t)
+	{
+		return [&](uint32_t id, Command::Action action, int amount)
+		{
+			lock_guard<mutex> lock{ mtx };
+			Command{ locked_accounts[id], action, amount }.call();
+		};
+	});
+
+	CommandRouter router{ account_count, producers, shard_count };
+	const auto start = chrono::steady_clock::now();
+	run_producers([&](size_t p)
+	{
+		return [&, p](uint32_t id, Command::Action action, int amount) { router.post(p, id, action, amount); };
+	});
+	router.stop();
+	const chrono::duration<double> routed = chrono::steady_clock::now() - start;
+
+	bool same = true;
+	for(uint32_t i = 0; i < account_count; ++i)
+		same &= router.account(i).balance == locked_accounts[i].balance;
+
+	// Queues whose capacity isn't a power of two are rounded up, rather than losing commands
+	CommandRouter odd{ 4, 1, 2, 6 };
+	BankAccount expected;
+	expected.report = nullptr;
+	for(int i = 0; i < 100000; ++i)
+	{
+		const auto action = i % 3 ? Command::deposit : Command::withdraw;
+		odd.post(0, 1, action, i % 100);
+		Command{ expected, action, i % 100 }.call();
+	}
+	odd.stop();
+
+	const auto total = static_cast<double>(producers * per_producer);
+	cout << producers << " producers, " << shard_count << " shards" << endl
+		 << "  one lock: " << total / locked.count() / 1e6 << "M commands/sec" << endl
+		 << "  router:   " << total / routed.count() / 1e6 << "M commands/sec" << endl
+		 << (same ? "balances match" : "balances differ!") << endl
+		 << (odd.account(1).balance == expected.balance ? "capacity 6 queue loses nothing" : "capacity 6 queue lost commands!") << endl;
+
+	getchar();
+	return EXIT_SUCCESS;
+}
+
+// The same commands reported each of the ways an account can report
+int CommandPattern_Report_main(int argc, char* argv[])
+{
+	const size_t command_count = 2000000;
+
+	const auto run = [&](const string& name, Account_Report::Report* report, ofstream& ofs)
+	{
+		mt19937 rng{ 42 };
+		uniform_int_distribution<int> amount{ 1, 300 };
+		bernoulli_distribution deposit{ 0.5 };
+		BankAccount ba;
+		ba.report = report;
+
+		const auto start = chrono::steady_clock::now();
+		for(size_t i = 0; i < command_count; ++i)
+			Command{ ba, deposit(rng) ? Command::deposit : Command::withdraw, amount(rng) }.call();
+		if(report)
+			report->flush();
+		ofs.flush();
+		const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+		cout << name << ": " << command_count / elapsed.count() / 1e6 << "M commands/sec, "
+			 << ofs.tellp() << " bytes, balance " << ba.balance << endl;
+	};
+
+	{
+		ofstream ofs{ "report_none.txt" };
+		run("none   ", nullptr, ofs);
+	}
+	{
+		ofstream ofs{ "report_console.txt" };
+		Account_Report::ConsoleReport report{ ofs };
+		run("console", &report, ofs);
+	}
+	{
+		ofstream ofs{ "report_text.txt" };
+		Account_Report::TextReport report{ ofs };
+		run("text   ", &report, ofs);
+	}
+	{
+		ofstream ofs{ "report_binary.bin", ios::binary };
+		Account_Report::BinaryReport report{ ofs };
+		run("binary ", &report, ofs);
+	}
+
+	// The sizes were all we wanted from them
+	for(auto name : { "report_none.txt", "report_console.txt", "report_text.txt", "report_binary.bin" })
+		std::remove(name);
+
+	getchar();
+	return EXIT_SUCCESS;
+}
@@ -1,7 +1,14 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <cstdint>
+#include <random>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <memory>
 using namespace std;
+#include "AccountReport.h"
 
 namespace CompositeCommandPattern
 {
@@ -10,22 +17,28 @@ namespace CompositeCommandPattern
 	
 	struct BankAccount
 	{
+		uint32_t id = 0;
 		int balance = 0;
 		int overdraft_limit = -500;
+		Account_Report::Report* report = &Account_Report::console(); // nullptr to say nothing
 
 		void deposit(int amount)
 		{
 			balance += amount;
-			cout << "deposited " << amount << ", balance now " << balance << endl;
+			if(report)
+				report->deposited(id, amount, balance);
 		}
 
-		void withdraw(int amount)
+		bool withdraw(int amount) // false if it would go past the overdraft limit
 		{
 			if(balance - amount >= overdraft_limit)
 			{
 				balance -= amount;
-				cout << "withdrew " << amount << ", balance now " << balance << endl;
+				if(report)
+					report->withdrew(id, amount, balance);
+				return true;
 			}
+			return false;
 		}
 	};
 
@@ -33,7 +46,7 @@ namespace CompositeCommandPattern
 	{
 		virtual ~ICommand() = default;
 		virtual void call() const = 0;
-		virtual void undo() const = 0;
+		virtual bool undo() const = 0; // false if it couldn't all be undone
 	};
 
 	struct Command : ICommand
@@ -41,6 +54,7 @@ namespace CompositeCommandPattern
 		BankAccount& account; // If we wanted to serialize we could instead use a unique identifier
 		enum Action {deposit, withdraw} action;
 		int amount;
+		mutable bool succeeded = false; // A refused withdrawal did nothing, so there is nothing to undo
 
 		Command(BankAccount& account, Action action, int amount)
 			: account{account},
@@ -55,29 +69,34 @@ namespace CompositeCommandPattern
 			switch(action) { 
 				case deposit: 
 					account.deposit(amount);
+					succeeded = true;
 					break;
 				case withdraw: 
-					account.withdraw(amount);
+					succeeded = account.withdraw(amount);
 					break;
 				default: 
 					break;
 			}
 		}
 
-		void undo() const override
+		bool undo() const override
 		{	// Swapped withdraw and deposit
 			// Obviously not the best way of doing this,
 			// though proves the concept
+			if(!succeeded)
+				return true;
 			switch(action) { 
-				case deposit: 
-					account.withdraw(amount);
+				case deposit: // the money may have been spent since, then the deposit stays
+					succeeded = !account.withdraw(amount);
 					break;
 				case withdraw: 
 					account.deposit(amount);
+					succeeded = false;
 					break;
 				default: 
 					break;
 			}
+			return !succeeded;
 		}
 	};
 
@@ -85,6 +104,8 @@ namespace CompositeCommandPattern
 	{	// This is now a vector, it has a storage of commands
 		// This is also an ICommand
 
+		CommandList() = default;
+
 		CommandList(const initializer_list<Command>& _Ilist)
 			: vector<Command>{_Ilist}
 		{
@@ -96,13 +117,179 @@ namespace CompositeCommandPattern
 				cmd.call();
 		}
 
-		void undo() const override
+		bool undo() const override
 		{
 			// We must loop through the collection in reverse
-			for_each(rbegin(), rend(), [](const Command& cmd)
+			bool all = true;
+			for_each(rbegin(), rend(), [&](const Command& cmd)
 			{
-				cmd.undo();
+				all &= cmd.undo();
 			});
+			return all;
+		}
+	};
+
+	// A CommandList calls every command it can. A Transaction is all or nothing, if any
+	// command is refused the ones before it are undone, so the accounts end up as they started.
+	// Undoing a deposit is a withdrawal, which can be refused too, so it says if that went wrong
+	struct Transaction : CommandList
+	{
+		enum Outcome {pending, committed, rolled_back, rollback_failed};
+		mutable Outcome outcome = pending;
+
+		using CommandList::CommandList;
+
+		void call() const override
+		{
+			for(auto it = begin(); it != end(); ++it)
+			{
+				it->call();
+				if(!it->succeeded)
+				{
+					bool all = true;
+					for_each(const_reverse_iterator{ it }, rend(), [&](const Command& cmd)
+					{
+						all &= cmd.undo();
+					});
+					outcome = all ? rolled_back : rollback_failed;
+					return;
+				}
+			}
+			outcome = committed;
+		}
+
+		bool undo() const override
+		{
+			if(outcome != committed)
+				return outcome != rollback_failed; // rolled back already, or never called
+			const auto all = CommandList::undo();
+			outcome = all ? rolled_back : rollback_failed;
+			return all;
+		}
+
+		// The same as call(), with the accounts shared between threads. Commands on different
+		// accounts can't affect each other, so the list is split up once, the account's id picking
+		// which thread its commands go to, in their order. Accounts sharing an id just share a thread.
+		// Once any command is refused the others stop and undo what they did.
+		// The accounts' reports are locked while the threads share them, their lines may interleave
+		void call_parallel(size_t threads = thread::hardware_concurrency()) const
+		{
+			using Account_Report::LockedReport;
+			threads = max<size_t>(1, threads);
+			vector<vector<uint32_t>> parts(threads); // positions in the list, for each thread
+			for(auto& part : parts)
+				part.reserve(size() / threads + 1);
+			vector<pair<Account_Report::Report*, unique_ptr<LockedReport>>> locked; // few reports, many accounts
+			vector<pair<BankAccount*, Account_Report::Report*>> unlocked; // to put back afterwards
+			for(uint32_t i = 0; i < size(); ++i)
+			{
+				auto& account = (*this)[i].account;
+				const auto is_locked = [&](const pair<Account_Report::Report*, unique_ptr<LockedReport>>& l)
+				{
+					return l.second.get() == account.report;
+				};
+				if(account.report && none_of(locked.begin(), locked.end(), is_locked))
+				{
+					auto l = find_if(locked.begin(), locked.end(), [&](auto& l) { return l.first == account.report; });
+					if(l == locked.end())
+						l = locked.emplace(locked.end(), account.report, make_unique<LockedReport>(*account.report));
+					unlocked.emplace_back(&account, account.report);
+					account.report = l->second.get();
+				}
+				// A multiply and a shift rather than id % threads, a divide per command costs more than the command
+				const auto mixed = static_cast<uint64_t>(account.id * 2654435769u);
+				parts[(mixed * threads) >> 32].push_back(i);
+			}
+
+			vector<size_t> reached(threads, 0); // how much of its part each thread called
+			atomic<bool> refused{ false }, stuck{ false };
+			const auto each_thread = [&](auto work)
+			{
+				vector<thread> workers;
+				for(size_t t = 0; t < threads; ++t)
+					workers.emplace_back([&, t] { work(parts[t], reached[t]); });
+				for(auto& w : workers)
+					w.join();
+			};
+
+			each_thread([&](const vector<uint32_t>& part, size_t& done)
+			{
+				while(done < part.size() && !refused.load(memory_order_relaxed))
+				{
+					auto& cmd = (*this)[part[done++]];
+					cmd.call();
+					if(!cmd.succeeded)
+						refused = true;
+				}
+			});
+
+			if(!refused)
+				outcome = committed;
+			else
+			{
+				each_thread([&](const vector<uint32_t>& part, size_t& done)
+				{
+					for(auto i = done; i-- > 0;)
+						if(!(*this)[part[i]].undo())
+							stuck = true;
+				});
+				outcome = stuck ? rollback_failed : rolled_back;
+			}
+
+			for(auto& u : unlocked)
+				u.first->report = u.second;
+		}
+	};
+
+	// With lots of accounts and lots of commands, going one BankAccount at a time jumps all
+	// over memory. Instead we can keep every account's balance in one column, and its limit in another
+	struct Accounts
+	{
+		vector<int> balance;
+		vector<int> overdraft_limit;
+
+		explicit Accounts(size_t count)
+			: balance(count, 0),
+			  overdraft_limit(count, -500)
+		{
+		}
+
+		size_t size() const
+		{
+			return balance.size();
+		}
+	};
+
+	// A command that names its account by number, rather than holding on to it
+	struct AccountCommand
+	{
+		uint32_t account;
+		Command::Action action;
+		int amount;
+	};
+
+	// Applies a big batch of commands to the columns, in the order they are in the batch,
+	// as each account's commands must happen in order. A balance and a limit are 8 bytes
+	// an account rather than a whole BankAccount, so more of them stay in the cache.
+	// Regrouping the batch by account first, into rounds or into one run per account, costs
+	// more passes over the batch than it saves, and rounds need memory for the busiest
+	// account's commands times every account. So it's one pass and no extra memory.
+	// Nothing is reported, the batch is about getting through the commands
+	class CommandBatch : public vector<AccountCommand>
+	{
+	public:
+		using vector<AccountCommand>::vector;
+
+		void apply(Accounts& accounts) const
+		{
+			int* balance = accounts.balance.data();
+			const int* limit = accounts.overdraft_limit.data();
+			for(auto& cmd : *this)
+			{	// The same rule as BankAccount::withdraw, a withdrawal past the limit does nothing
+				const int after = balance[cmd.account] + (cmd.action == Command::deposit ? cmd.amount : -cmd.amount);
+				if(cmd.action == Command::deposit || after >= limit[cmd.account])
+					balance[cmd.account] = after;
+			}
 		}
 	};
 
@@ -131,4 +318,117 @@ int CompositeCommandPattern_main(int argc, char* argv[])
 
 	getchar();
 	return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
+
+// A big batch applied one account at a time against applied as columns
+int CompositeCommandPattern_Batch_main(int argc, char* argv[])
+{
+	const size_t account_count = 10000;
+	const size_t command_count = 4000000;
+
+	mt19937 rng{ 42 };
+	uniform_int_distribution<uint32_t> which{ 0, account_count - 1 };
+	uniform_int_distribution<int> amount{ 1, 300 };
+	bernoulli_distribution deposit{ 0.45 }; // so plenty of withdrawals hit the limit
+	CommandBatch batch;
+	for(size_t i = 0; i < command_count; ++i)
+		batch.push_back({ which(rng), deposit(rng) ? Command::deposit : Command::withdraw, amount(rng) });
+
+	vector<BankAccount> one_at_a_time(account_count);
+	for(uint32_t i = 0; i < account_count; ++i)
+	{
+		one_at_a_time[i].id = i;
+		one_at_a_time[i].report = nullptr;
+	}
+	auto start = chrono::steady_clock::now();
+	for(auto& cmd : batch)
+		Command{ one_at_a_time[cmd.account], cmd.action, cmd.amount }.call();
+	const chrono::duration<double> accounts_time = chrono::steady_clock::now() - start;
+
+	Accounts columns{ account_count };
+	start = chrono::steady_clock::now();
+	batch.apply(columns);
+	const chrono::duration<double> columns_time = chrono::steady_clock::now() - start;
+
+	bool same = true;
+	for(size_t i = 0; i < account_count; ++i)
+		same &= one_at_a_time[i].balance == columns.balance[i];
+
+	cout << "one account at a time: " << command_count / accounts_time.count() / 1e6 << "M commands/sec" << endl
+		 << "columns:               " << command_count / columns_time.count() / 1e6 << "M commands/sec" << endl
+		 << (same ? "balances match" : "balances differ!") << endl;
+
+	getchar();
+	return EXIT_SUCCESS;
+}
+
+// Big transactions run one command at a time and split across threads, one that
+// goes through and one that is refused at the very end and must leave no trace
+int CompositeCommandPattern_Transaction_main(int argc, char* argv[])
+{
+	const size_t account_count = 1000;
+	const size_t command_count = 2000000;
+
+	const auto make_accounts = [&]
+	{
+		vector<BankAccount> accounts(account_count);
+		for(uint32_t i = 0; i < account_count; ++i)
+		{
+			accounts[i].id = i;
+			accounts[i].report = nullptr;
+		}
+		return accounts;
+	};
+	const auto make_list = [&](vector<BankAccount>& accounts, bool refuse_last)
+	{
+		mt19937 rng{ 42 };
+		uniform_int_distribution<uint32_t> which{ 0, account_count - 1 };
+		uniform_int_distribution<int> amount{ 1, 100 };
+		Transaction list;
+		list.reserve(command_count + 1);
+		for(size_t i = 0; i < command_count / 2; ++i)
+		{	// each withdrawal follows a bigger deposit, so none are refused
+			auto& account = accounts[which(rng)];
+			list.emplace_back(account, Command::deposit, amount(rng) + 100);
+			list.emplace_back(account, Command::withdraw, 100);
+		}
+		if(refuse_last)
+			list.emplace_back(accounts[0], Command::withdraw, 1000000000);
+		return list;
+	};
+
+	const char* outcomes[]{ "not called", "committed", "rolled back", "couldn't roll back" };
+	for(bool refuse_last : { false, true })
+	{
+		auto serial_accounts = make_accounts();
+		auto parallel_accounts = make_accounts();
+		const auto serial = make_list(serial_accounts, refuse_last);
+		const auto parallel = make_list(parallel_accounts, refuse_last);
+
+		auto start = chrono::steady_clock::now();
+		serial.call();
+		const chrono::duration<double> serial_time = chrono::steady_clock::now() - start;
+
+		start = chrono::steady_clock::now();
+		parallel.call_parallel();
+		const chrono::duration<double> parallel_time = chrono::steady_clock::now() - start;
+
+		bool same = serial.outcome == parallel.outcome;
+		bool untouched = true;
+		for(size_t i = 0; i < account_count; ++i)
+		{
+			same &= serial_accounts[i].balance == parallel_accounts[i].balance;
+			untouched &= serial_accounts[i].balance == 0;
+		}
+
+		cout << (refuse_last ? "refused at the end: " : "all go through:     ")
+			 << "one at a time " << serial_time.count() * 1000 << "ms, "
+			 << "in parts " << parallel_time.count() * 1000 << "ms, "
+			 << outcomes[serial.outcome]
+			 << (same ? ", balances match" : ", balances differ!")
+			 << (serial.outcome == Transaction::rolled_back && !untouched ? ", but not rolled back!" : "") << endl;
+	}
+
+	getchar();
+	return EXIT_SUCCESS;
+}
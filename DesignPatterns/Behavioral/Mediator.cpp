@@ -3,10 +3,13 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <random>
+#include <chrono>
 using namespace std;
 
-#include <boost/signals2.hpp>
-using namespace boost::signals2;
+#include "Signal/Signal.h"
+#include "Signal/EventBus.h"
+using namespace Signals;
 
 namespace Mediator_EventBus
 {
@@ -58,7 +61,7 @@ namespace Mediator_EventBus
     // This is our EventBroker
     struct Game
     {
-        signal<void(Event*)> events; // We use boost::signals, this is our observer
+        EventBus<> events; // Our own single threaded signals, one for each type of event
     };
 
     struct Player
@@ -79,7 +82,7 @@ namespace Mediator_EventBus
             goals_scored++;
             PlayerScored ps{name, goals_scored};
             ps.print(); // Lets also print out the scored details
-            game.events(&ps);
+            game.events.publish(ps);
         }
     };
 
@@ -87,25 +90,25 @@ namespace Mediator_EventBus
     struct Coach
     {
         Game& game;
+        connection scored;
 
         explicit Coach(Game& game)
             : game{game}
         {
-            game.events.connect([](Event* e)
+            // We only subscribe to the event we care about, so there's no need
+            // to dynamic_cast every event to find out what it is
+            scored = game.events.subscribe<PlayerScored>([](const PlayerScored& ps)
             {
-                // Our event is polymorphic, because we're using pointers we can safely perform
-                // a dynamic_cast without a try/catch block, as the result will be a nullptr
-                PlayerScored* ps = dynamic_cast<PlayerScored*>(e);
-                if(ps && ps->goals_scored_so_far < 3) // Lets only do something for the first couple of goals
+                if(ps.goals_scored_so_far < 3) // Lets only do something for the first couple of goals
                 {
-                    cout << "coach says: well done, " << ps->player_name << endl;
+                    cout << "coach says: well done, " << ps.player_name << endl;
                 }
             });
         }
 
         ~Coach()
         {   // A good idea to clean up some
-            game.events.disconnect_all_slots();
+            scored.disconnect();
         }
     };
 
@@ -125,4 +128,106 @@ int Mediator_EventBus_main(int argc, char* argv[])
 
 	getchar();
 	return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
+
+namespace Mediator_EventBus
+{
+    // Lots of kinds of event, each with a few handlers
+    template <int I>
+    struct Tick : Event
+    {
+        int value;
+
+        explicit Tick(int value)
+            : value{value}
+        {
+        }
+
+        void print() const override
+        {
+            cout << "tick " << I << ": " << value << endl;
+        }
+    };
+
+    unsigned handled = 0;
+
+    // Every handler on the one signal, each casting to see if the event is its type
+    template <int I>
+    void connect_casting(Signal<void(Event*)>& events, size_t handlers)
+    {
+        for(size_t h = 0; h < handlers; ++h)
+        {
+            events.connect([](Event* e)
+            {
+                if(auto t = dynamic_cast<Tick<I>*>(e))
+                    handled += t->value;
+            });
+        }
+    }
+
+    template <int I>
+    void subscribe_typed(EventBus<>& events, size_t handlers)
+    {
+        for(size_t h = 0; h < handlers; ++h)
+            events.subscribe<Tick<I>>([](const Tick<I>& t) { handled += t.value; });
+    }
+
+    template <int... Is>
+    struct Ticks
+    {
+        static void connect(Signal<void(Event*)>& events, size_t handlers)
+        {
+            int expand[]{ (connect_casting<Is>(events, handlers), 0)... };
+            (void)expand;
+        }
+
+        static void subscribe(EventBus<>& events, size_t handlers)
+        {
+            int expand[]{ (subscribe_typed<Is>(events, handlers), 0)... };
+            (void)expand;
+        }
+
+        // Publishes a Tick<kind> without knowing kind at compile time
+        template <typename Publish>
+        static void publish(int kind, int value, Publish publish)
+        {
+            int expand[]{ (kind == Is ? (publish(Tick<Is>{ value }), 0) : 0)... };
+            (void)expand;
+        }
+    };
+}
+
+// Publishing to one signal that every handler filters, against the typed event bus
+int Mediator_EventBus_Benchmark_main(int argc, char* argv[])
+{
+    using AllTicks = Ticks<0, 1, 2, 3, 4, 5, 6, 7>;
+    const size_t handlers_per_type = 4;
+    const size_t events = 1000000;
+
+    mt19937 rng{ 42 };
+    uniform_int_distribution<int> kind{ 0, 7 };
+    vector<int> kinds(events);
+    for(auto& k : kinds)
+        k = kind(rng);
+
+    Signal<void(Event*)> one_signal;
+    AllTicks::connect(one_signal, handlers_per_type);
+    EventBus<> bus;
+    AllTicks::subscribe(bus, handlers_per_type);
+
+    const auto run = [&](const string& name, auto publish)
+    {
+        handled = 0;
+        const auto start = chrono::steady_clock::now();
+        for(auto k : kinds)
+            AllTicks::publish(k, 1, publish);
+        const chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+        cout << name << elapsed.count() / events << "ns/event, " << handled << " handled" << endl;
+    };
+
+    run("one signal, dynamic_cast: ", [&](auto&& e) { one_signal(&e); });
+    run("typed event bus:          ", [&](auto&& e) { bus.publish(e); });
+
+    getchar();
+    return EXIT_SUCCESS;
+}
@@ -1,7 +1,19 @@
+#define _SCL_SECURE_NO_WARNINGS // boost compile errors
 #include <iostream>
+#include <fstream>
+#include <string>
+#include <deque>
 #include <vector>
 #include <memory>
+#include <cstdint>
+#include <chrono>
+#include <random>
+#include <sstream>
+#include <array>
+#include <cstdio>
 using namespace std;
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 
 namespace Momento
 {
@@ -101,6 +113,490 @@ namespace Momento
         }
     };
 
+    // Keeping every snapshot forever, each in its own allocation, soon adds up.
+    // This account keeps a bounded history instead: each change is stored as the difference
+    // it made, and every keyframe_interval changes the whole balance is stored too.
+    // Both live in ring buffers sized once from a memory budget, when they fill up the
+    // oldest block of changes is forgotten. Undo and redo apply one difference,
+    // restoring walks forward from the keyframe before it, at most keyframe_interval steps
+    class BoundedBankAccount
+    {
+    public:
+        // Names a point in the history, rather than holding a copy of the state.
+        // A change made after an undo drops the changes we could have redone, and the
+        // ones after it reuse their numbers. So each change is also stamped with the branch
+        // of the history it was made in, and a momento only matches a change in its own branch
+        class Momento
+        {
+            uint64_t change;
+            uint32_t branch;
+        public:
+            explicit Momento(uint64_t change, uint32_t branch = 0)
+                : change{change},
+                  branch{branch}
+            {
+            }
+            friend class BoundedBankAccount;
+        };
+
+        static constexpr uint64_t keyframe_interval = 16;
+    private:
+        int balance;
+        vector<int32_t> deltas;     // deltas[change % capacity] is what change did to the balance
+        vector<int32_t> keyframes;  // the balance after every keyframe_interval'th change
+        vector<uint32_t> branches;  // branches[change % capacity] is the branch change was made in
+        uint32_t branch = 0;        // goes up every time changes are dropped
+        uint64_t capacity;
+        uint64_t oldest = 0;        // the first change we can still go back to, always on a keyframe
+        uint64_t newest = 0;        // the last change, past current if we have undone some
+        uint64_t current = 0;
+
+        int32_t& keyframe(uint64_t change)
+        {
+            return keyframes[(change / keyframe_interval) % keyframes.size()];
+        }
+
+        void record(int after)
+        {
+            if(current < newest)
+                ++branch; // anything we could have redone is gone now
+            const auto change = ++current;
+            newest = current;
+            deltas[change % capacity] = after - balance;
+            branches[change % capacity] = branch;
+            if(change % keyframe_interval == 0)
+                keyframe(change) = after;
+            balance = after;
+
+            if(newest - oldest >= capacity)
+                oldest += keyframe_interval; // forget the oldest block
+        }
+    public:
+        BoundedBankAccount(int balance, size_t memory_budget) // in bytes
+            : balance{balance}
+        {
+            const auto per_change = sizeof(int32_t) + sizeof(uint32_t) + sizeof(int32_t) / static_cast<double>(keyframe_interval);
+            const auto blocks = max<uint64_t>(2, static_cast<uint64_t>(memory_budget / per_change) / keyframe_interval);
+            capacity = blocks * keyframe_interval;
+            deltas.resize(static_cast<size_t>(capacity));
+            branches.resize(static_cast<size_t>(capacity));
+            keyframes.resize(static_cast<size_t>(blocks));
+            keyframe(0) = balance;
+        }
+
+        Momento deposit(int amount)
+        {
+            record(balance + amount);
+            return Momento{ current, branch };
+        }
+
+        // False if the snapshot is so old it has been forgotten, or the change it names
+        // was dropped by a change made after undoing it
+        bool restore(const Momento& m)
+        {
+            if(m.change < oldest || m.change > newest || branches[m.change % capacity] != m.branch)
+                return false;
+            auto change = m.change - m.change % keyframe_interval;
+            auto b = keyframe(change);
+            while(change < m.change)
+                b += deltas[++change % capacity];
+            record(b);
+            return true;
+        }
+
+        bool undo()
+        {
+            if(current == oldest)
+                return false;
+            balance -= deltas[current-- % capacity];
+            return true;
+        }
+
+        bool redo()
+        {
+            if(current == newest)
+                return false;
+            balance += deltas[++current % capacity];
+            return true;
+        }
+
+        size_t memory_used() const
+        {
+            return deltas.capacity() * sizeof(int32_t) + branches.capacity() * sizeof(uint32_t) + keyframes.capacity() * sizeof(int32_t);
+        }
+
+        friend std::ostream& operator<<(std::ostream& os, const BoundedBankAccount& obj)
+        {
+            return os << "balance: " << obj.balance;
+        }
+    };
+
+    // When the state is big, a whole bank of accounts say, copying all of it for every
+    // snapshot is hopeless. Instead the balances live in a tree, 32 to a leaf and 32 children
+    // to a branch, and the tree is never changed, only copied. Changing a balance copies just
+    // the leaf and the branches above it, everything else is shared with the old tree.
+    // So a snapshot is a copy of the root pointer, and each change costs a few nodes
+    class Balances
+    {
+        static constexpr unsigned bits = 5;
+        static constexpr size_t width = 1 << bits;
+        static constexpr size_t mask = width - 1;
+
+        static size_t& bytes()
+        {
+            static size_t in_use = 0;
+            return in_use;
+        }
+
+        // Both kinds of node keep track of how much memory the trees use
+        template <typename T>
+        struct Counted
+        {
+            Counted() { bytes() += sizeof(T); }
+            Counted(const Counted&) { bytes() += sizeof(T); }
+            ~Counted() { bytes() -= sizeof(T); }
+        };
+
+        struct Leaf : Counted<Leaf>
+        {
+            array<int, width> values{};
+        };
+
+        struct Branch : Counted<Branch>
+        {
+            array<shared_ptr<const void>, width> children; // Branches, or Leaves on the last level
+        };
+
+        shared_ptr<const void> root;
+        unsigned levels = 0; // branch levels above the leaves
+        size_t count;
+
+        shared_ptr<const void> set(const shared_ptr<const void>& node, unsigned level, size_t index, int value)
+        {
+            if(level == 0)
+            {
+                auto leaf = make_shared<Leaf>(*static_pointer_cast<const Leaf>(node));
+                leaf->values[index & mask] = value;
+                return leaf;
+            }
+            auto branch = make_shared<Branch>(*static_pointer_cast<const Branch>(node));
+            auto& child = branch->children[(index >> (level * bits)) & mask];
+            child = set(child, level - 1, index, value);
+            return branch;
+        }
+    public:
+        // Every account starts at zero, sharing one empty node per level
+        explicit Balances(size_t count)
+            : count{count}
+        {
+            root = make_shared<Leaf>();
+            for(size_t reach = width; reach < count; reach *= width)
+            {
+                auto branch = make_shared<Branch>();
+                branch->children.fill(root);
+                root = branch;
+                ++levels;
+            }
+        }
+
+        size_t size() const
+        {
+            return count;
+        }
+
+        int operator[](size_t index) const
+        {
+            auto node = root.get();
+            for(auto level = levels; level > 0; --level)
+                node = static_cast<const Branch*>(node)->children[(index >> (level * bits)) & mask].get();
+            return static_cast<const Leaf*>(node)->values[index & mask];
+        }
+
+        void set(size_t index, int value)
+        {
+            root = set(root, levels, index, value);
+        }
+
+        // How much memory every tree together is using
+        static size_t bytes_in_use()
+        {
+            return bytes();
+        }
+    };
+
+    // A bank with snapshots, like BankAccount above, but of a whole lot of accounts
+    class Bank
+    {
+    public:
+        class Momento
+        {
+            Balances balances; // only a root pointer, the tree underneath is shared
+        public:
+            explicit Momento(const Balances& balances)
+                : balances{balances}
+            {
+            }
+            friend class Bank;
+        };
+    private:
+        Balances balances;
+        vector<Momento> changes;
+        size_t current = 0;
+    public:
+        explicit Bank(size_t accounts)
+            : balances{accounts}
+        {
+            changes.emplace_back(balances);
+        }
+
+        Momento deposit(size_t account, int amount)
+        {
+            balances.set(account, balances[account] + amount);
+            changes.erase(changes.begin() + current + 1, changes.end()); // nothing left to redo
+            changes.emplace_back(balances);
+            ++current;
+            return changes.back();
+        }
+
+        void restore(const Momento& m)
+        {
+            balances = m.balances;
+            changes.push_back(m);
+            current = changes.size() - 1;
+        }
+
+        bool undo()
+        {
+            if(current == 0)
+                return false;
+            balances = changes[--current].balances;
+            return true;
+        }
+
+        bool redo()
+        {
+            if(current + 1 == changes.size())
+                return false;
+            balances = changes[++current].balances;
+            return true;
+        }
+
+        int balance(size_t account) const
+        {
+            return balances[account];
+        }
+    };
+
+    // Like BoundedBankAccount, but nothing is forgotten. Changes are kept as differences in
+    // segments, each starting with the balance before its first change. Only the newest few
+    // segments stay in memory, older ones are written out to a file of fixed size segments.
+    // When undo or restore goes back that far the file is mapped in and read where it lies,
+    // the OS only loads the pages we touch
+    class SpillingBankAccount
+    {
+    public:
+        // Like BoundedBankAccount's, a change number and the branch of the history it was made in
+        class Momento
+        {
+            uint64_t change;
+            uint32_t branch;
+        public:
+            explicit Momento(uint64_t change, uint32_t branch = 0)
+                : change{change},
+                  branch{branch}
+            {
+            }
+            friend class SpillingBankAccount;
+        };
+
+        static constexpr uint64_t segment_changes = 4096;
+    private:
+        struct Segment
+        {
+            int32_t keyframe; // the balance before the first change
+            int32_t deltas[segment_changes];
+        };
+
+        const int initial;
+        int balance;
+        uint64_t newest = 0;
+        uint64_t current = 0;
+        // Where each branch ended, the changes after branch_points[b] were dropped when branch b + 1
+        // began. Rather than stamping every change on disk, it's one number for each undo then change
+        vector<uint64_t> branch_points;
+
+        deque<Segment> hot;      // the newest segments
+        uint64_t first_hot = 0;  // segment number of hot.front(), those before it are in the file
+        const size_t hot_limit;
+
+        const string path;
+        fstream file;
+        boost::interprocess::file_mapping mapping;
+        boost::interprocess::mapped_region region;
+        uint64_t mapped_segments = 0;
+        uint64_t remaps = 0;
+
+        const Segment& spilled(uint64_t n)
+        {
+            using namespace boost::interprocess;
+            if(n >= mapped_segments)
+            {	// Written since we last mapped the file, so map it again
+                mapping = file_mapping{ path.c_str(), read_only };
+                region = mapped_region{ mapping, read_only };
+                mapped_segments = region.get_size() / sizeof(Segment);
+                ++remaps;
+            }
+            return static_cast<const Segment*>(region.get_address())[n];
+        }
+
+        const Segment& segment(uint64_t n)
+        {
+            return n >= first_hot ? hot[static_cast<size_t>(n - first_hot)] : spilled(n);
+        }
+
+        int32_t delta(uint64_t change)
+        {
+            return segment((change - 1) / segment_changes).deltas[(change - 1) % segment_changes];
+        }
+
+        void spill()
+        {
+            while(hot.size() > hot_limit)
+            {
+                file.seekp(static_cast<streamoff>(first_hot * sizeof(Segment)));
+                file.write(reinterpret_cast<const char*>(&hot.front()), sizeof(Segment));
+                file.flush(); // a segment written again must not be read through the mapping while it sits in the buffer
+                hot.pop_front();
+                ++first_hot;
+            }
+        }
+
+        // Changes after current are being replaced. If the segment current is in has
+        // been spilled, it comes back into memory so we can carry on writing it
+        void truncate()
+        {
+            const auto keep = (current + segment_changes - 1) / segment_changes; // segments with changes 1..current
+            if(keep <= first_hot)
+            {
+                hot.clear();
+                first_hot = keep;
+                if(current % segment_changes != 0)
+                {
+                    hot.push_back(spilled(keep - 1));
+                    first_hot = keep - 1;
+                }
+            }
+            else
+            {
+                hot.erase(hot.begin() + static_cast<ptrdiff_t>(keep - first_hot), hot.end());
+            }
+        }
+
+        void record(int after)
+        {
+            if(current < newest)
+            {
+                truncate();
+                branch_points.push_back(current);
+            }
+            const auto change = ++current;
+            newest = current;
+
+            const auto offset = (change - 1) % segment_changes;
+            if(offset == 0)
+            {
+                hot.emplace_back();
+                hot.back().keyframe = balance;
+                spill();
+            }
+            hot.back().deltas[offset] = after - balance;
+            balance = after;
+        }
+    public:
+        SpillingBankAccount(int balance, const string& path, size_t hot_segments = 4)
+            : initial{balance},
+              balance{balance},
+              hot_limit{max<size_t>(1, hot_segments)},
+              path{path}
+        {
+            file.open(path, ios::in | ios::out | ios::binary | ios::trunc);
+        }
+
+        ~SpillingBankAccount()
+        {
+            region = boost::interprocess::mapped_region{}; // unmapped before the file can go
+            file.close();
+            std::remove(path.c_str());
+        }
+
+        SpillingBankAccount(const SpillingBankAccount&) = delete;
+        SpillingBankAccount& operator=(const SpillingBankAccount&) = delete;
+
+        Momento deposit(int amount)
+        {
+            record(balance + amount);
+            return Momento{ current, static_cast<uint32_t>(branch_points.size()) };
+        }
+
+        // False if the change it names was dropped by a change made after undoing it
+        bool restore(const Momento& m)
+        {
+            if(m.change > newest || m.branch > branch_points.size())
+                return false;
+            for(auto b = m.branch; b < branch_points.size(); ++b)
+                if(branch_points[b] < m.change)
+                    return false;
+            int b = initial;
+            auto change = m.change;
+            if(change > 0)
+            {	// from the start of the segment the change is in
+                const auto n = (change - 1) / segment_changes;
+                b = segment(n).keyframe;
+                change = n * segment_changes;
+            }
+            while(change < m.change)
+                b += delta(++change);
+            record(b);
+            return true;
+        }
+
+        bool undo()
+        {
+            if(current == 0)
+                return false;
+            balance -= delta(current--);
+            return true;
+        }
+
+        bool redo()
+        {
+            if(current == newest)
+                return false;
+            balance += delta(++current);
+            return true;
+        }
+
+        size_t memory_used() const
+        {
+            return hot.size() * sizeof(Segment);
+        }
+
+        uint64_t spilled_bytes() const
+        {
+            return first_hot * sizeof(Segment);
+        }
+
+        uint64_t times_mapped() const
+        {
+            return remaps;
+        }
+
+        friend std::ostream& operator<<(std::ostream& os, const SpillingBankAccount& obj)
+        {
+            return os << "balance: " << obj.balance;
+        }
+    };
+
 }
 
 using namespace Momento;
@@ -129,4 +625,194 @@ int Momento_main(int argc, char* argv[])
 
 	getchar();
 	return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
+
+// Lots of changes kept as shared snapshots against kept as differences in a fixed budget
+int Momento_Bounded_main(int argc, char* argv[])
+{
+    const size_t changes = 2000000;
+    const size_t undos = 100000;
+
+    mt19937 rng{ 42 };
+    uniform_int_distribution<int> amount{ -100, 100 };
+    vector<int> amounts(changes);
+    for(auto& a : amounts)
+        a = amount(rng);
+
+    const auto time = [](auto work)
+    {
+        const auto start = chrono::steady_clock::now();
+        work();
+        return chrono::duration<double, milli>{ chrono::steady_clock::now() - start }.count();
+    };
+
+    BankAccount snapshots{ 0 };
+    const auto snapshot_deposits = time([&] { for(auto a : amounts) snapshots.desposit(a); });
+    const auto snapshot_undos = time([&] { for(size_t i = 0; i < undos; ++i) snapshots.undo(); });
+
+    BoundedBankAccount bounded{ 0, 1 << 20 }; // a megabyte, room for about 125k changes
+    Momento::BoundedBankAccount::Momento recent{ 0 };
+    const auto bounded_deposits = time([&]
+    {
+        for(size_t i = 0; i < changes; ++i)
+        {
+            auto m = bounded.deposit(amounts[i]);
+            if(i == changes - 1000)
+                recent = m;
+        }
+    });
+    const auto bounded_undos = time([&] { for(size_t i = 0; i < undos; ++i) bounded.undo(); });
+
+    ostringstream a, b;
+    a << snapshots;
+    b << bounded;
+    const auto forgotten = !bounded.restore(Momento::BoundedBankAccount::Momento{ 0 });
+
+    cout << "snapshots: " << snapshot_deposits << "ms to deposit, " << snapshot_undos << "ms to undo, "
+         << "about " << changes * (sizeof(shared_ptr<Momento::Momento>) + 32) / (1 << 20) << "MB" << endl
+         << "bounded:   " << bounded_deposits << "ms to deposit, " << bounded_undos << "ms to undo, "
+         << bounded.memory_used() / 1024 << "KB" << endl
+         << (a.str() == b.str() ? "same balance after undo" : "balances differ!") << endl
+         << (forgotten ? "the first change is forgotten" : "the first change should be forgotten!") << endl;
+
+    int expected = 0;
+    for(size_t i = 0; i <= changes - 1000; ++i)
+        expected += amounts[i];
+    bounded.restore(recent);
+    cout << "restored to 1000 changes from the end, " << bounded << " (expected " << expected << ")" << endl;
+
+    getchar();
+    return EXIT_SUCCESS;
+}
+
+// A million accounts with a snapshot after every deposit
+int Momento_Persistent_main(int argc, char* argv[])
+{
+    const size_t accounts = 1000000;
+    const size_t deposits = 100000;
+
+    mt19937 rng{ 42 };
+    uniform_int_distribution<size_t> which{ 0, accounts - 1 };
+    uniform_int_distribution<int> amount{ 1, 100 };
+
+    const auto empty = Balances::bytes_in_use();
+    Bank bank{ accounts };
+    const auto created = Balances::bytes_in_use();
+
+    vector<int> expected(accounts, 0); // to check against, as one plain array
+    Bank::Momento halfway{ Balances{ 0 } };
+    vector<int> expected_halfway;
+
+    const auto start = chrono::steady_clock::now();
+    for(size_t i = 0; i < deposits; ++i)
+    {
+        const auto account = which(rng);
+        const auto a = amount(rng);
+        auto m = bank.deposit(account, a);
+        expected[account] += a;
+        if(i == deposits / 2)
+        {
+            halfway = m;
+            expected_halfway = expected;
+        }
+    }
+    const chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+    const auto grown = Balances::bytes_in_use() - created;
+
+    // Copying the whole array for each snapshot instead, timed over a few
+    const size_t copies = 100;
+    vector<vector<int>> copied;
+    const auto copy_start = chrono::steady_clock::now();
+    for(size_t i = 0; i < copies; ++i)
+        copied.push_back(expected);
+    const chrono::duration<double, milli> copy_time = chrono::steady_clock::now() - copy_start;
+
+    bool same = true;
+    for(size_t i = 0; i < accounts; ++i)
+        same &= bank.balance(i) == expected[i];
+    bank.restore(halfway);
+    bool same_halfway = true;
+    for(size_t i = 0; i < accounts; ++i)
+        same_halfway &= bank.balance(i) == expected_halfway[i];
+
+    cout << "new bank of " << accounts << " accounts: " << (created - empty) << " bytes" << endl
+         << "shared snapshots: " << elapsed.count() * 1000 / deposits << "us and "
+         << grown / deposits << " bytes a snapshot" << endl
+         << "copied snapshots: " << copy_time.count() * 1000 / copies << "us and "
+         << accounts * sizeof(int) << " bytes a snapshot" << endl
+         << (same ? "balances match" : "balances differ!") << ", "
+         << (same_halfway ? "restored halfway" : "restore went wrong!") << endl;
+
+    getchar();
+    return EXIT_SUCCESS;
+}
+
+// A long history kept mostly on disk, undone all the way back and redone again
+int Momento_Spill_main(int argc, char* argv[])
+{
+    const size_t changes = 10000000;
+
+    mt19937 rng{ 42 };
+    uniform_int_distribution<int> amount{ -100, 100 };
+
+    SpillingBankAccount account{ 1000, "momento_history.bin" };
+    int expected = 1000;
+    int expected_early = 0;
+    SpillingBankAccount::Momento early{ 0 };
+
+    const auto time = [](auto work)
+    {
+        const auto start = chrono::steady_clock::now();
+        work();
+        return chrono::duration<double, milli>{ chrono::steady_clock::now() - start }.count();
+    };
+
+    const auto deposit_time = time([&]
+    {
+        for(size_t i = 0; i < changes; ++i)
+        {
+            const auto a = amount(rng);
+            expected += a;
+            auto m = account.deposit(a);
+            if(i == 12345)
+            {
+                early = m;
+                expected_early = expected;
+            }
+        }
+    });
+
+    const auto balance_of = [](const SpillingBankAccount& a)
+    {
+        ostringstream oss;
+        oss << a;
+        return oss.str();
+    };
+    const auto at_end = balance_of(account);
+    const auto memory = account.memory_used();
+    const auto spilled = account.spilled_bytes();
+
+    size_t undone = 0;
+    const auto undo_time = time([&] { while(account.undo()) ++undone; });
+    const auto at_start = balance_of(account);
+    const auto redo_time = time([&] { while(account.redo()); });
+    const auto redone = balance_of(account);
+
+    const auto restore_time = time([&] { account.restore(early); });
+    const auto restored = balance_of(account);
+
+    ostringstream want_end, want_early;
+    want_end << "balance: " << expected;
+    want_early << "balance: " << expected_early;
+
+    cout << changes << " changes, " << memory / 1024 << "KB in memory, " << spilled / (1 << 20) << "MB on disk" << endl
+         << "deposit " << deposit_time << "ms, undo all " << undo_time << "ms, redo all " << redo_time << "ms, "
+         << "restore " << restore_time << "ms, file mapped " << account.times_mapped() << " time(s)" << endl
+         << (at_end == want_end.str() ? "end balance right" : "end balance wrong!") << ", "
+         << (undone == changes && at_start == "balance: 1000" ? "undone to the start" : "undo went wrong!") << ", "
+         << (redone == at_end ? "redone to the end" : "redo went wrong!") << ", "
+         << (restored == want_early.str() ? "restored an early change" : "restore went wrong!") << endl;
+
+    getchar();
+    return EXIT_SUCCESS;
+}
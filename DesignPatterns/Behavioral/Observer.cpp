@@ -1,7 +1,15 @@
 #include <string>
 #include <vector>
 #include <iostream>
+#include <algorithm>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <tuple>
+#include <deque>
+#include <condition_variable>
 using namespace std;
 #include <boost/any.hpp>
 using namespace boost;
@@ -38,8 +46,72 @@ namespace Observer
                                    const any new_value) = 0;
     };
 
-    // Mutex - mutual exclusion, for thread safety
-    static mutex mtx;
+    // The string + any approach costs a string compare and an any_cast in every listener,
+    // and boxing the value into an any allocates. Instead each property can be a tag type
+    // known at compile time, which carries the type of its value
+    struct Age
+    {
+        using type = int;
+        static constexpr const char* name = "age";
+    };
+
+    struct CanVote
+    {
+        using type = bool;
+        static constexpr const char* name = "can_vote";
+    };
+
+    // A listener for a single property, it receives the value with its real type
+    template <typename Property>
+    struct PropertyListener
+    {
+        virtual ~PropertyListener() = default;
+        virtual void PropertyChanged(Person& p, const typename Property::type& new_value) = 0;
+    };
+
+    // A list of listeners, published as an immutable snapshot.
+    // Readers take the snapshot without locking, writers copy it, change the copy and publish it
+    template <typename Listener>
+    class ListenerList
+    {
+        using Listeners = vector<Listener*>;
+
+        std::shared_ptr<const Listeners> listeners = std::make_shared<const Listeners>();
+        mutex writer_mtx; // Serializes writers of this list only, readers never take it
+    public:
+        void subscribe(Listener* l)
+        {
+            lock_guard<mutex> guard{ writer_mtx }; // Only other subscribe/unsubscribe calls wait on this
+
+            const auto current = std::atomic_load(&listeners);
+            if(find(begin(*current), end(*current), l) != end(*current)) // Prevent double subscription
+                return;
+
+            // Copy-on-write, we never modify a list someone may be iterating
+            auto updated = std::make_shared<Listeners>(*current);
+            updated->push_back(l);
+            std::atomic_store(&listeners, std::shared_ptr<const Listeners>{ move(updated) });
+        }
+
+        void unsubscribe(Listener* l)
+        {
+            lock_guard<mutex> guard{ writer_mtx }; // thread safety
+
+            const auto current = std::atomic_load(&listeners);
+            auto updated = std::make_shared<Listeners>();
+            updated->reserve(current->size());
+            remove_copy(begin(*current), end(*current), back_inserter(*updated), l);
+            std::atomic_store(&listeners, std::shared_ptr<const Listeners>{ move(updated) });
+        }
+
+        // Take a snapshot of the listeners, no lock is held while they are called.
+        // A listener that (un)subscribes during the loop only affects the next snapshot,
+        // the one we are iterating stays alive until we let go of it
+        std::shared_ptr<const Listeners> snapshot() const
+        {
+            return std::atomic_load(&listeners);
+        }
+    };
 
     // our person
     struct Person
@@ -62,14 +134,15 @@ namespace Observer
 
             const auto old_can_vote = GetCanVote(); // This doesn't have a setter so we need to get it prior
 
+            const auto old_age = this->age;
             this->age = age;
-            notify("age", this->age); // let listeners know age changed
+            changed<Age>(old_age, this->age); // let listeners know age changed
 
             const auto new_can_vote = GetCanVote();
 
             if(old_can_vote != new_can_vote)
             {
-                notify("can_vote", new_can_vote); // let listeners know can_vote changed
+                changed<CanVote>(old_can_vote, new_can_vote); // let listeners know can_vote changed
             }
         }
 
@@ -79,46 +152,142 @@ namespace Observer
             return age >= 16;
         }
 
+        // When changing lots of things at once we don't want listeners told about every step.
+        // While a batch_update is alive notifications are held back, each property touched
+        // is then notified once with its final value when the (outermost) batch ends.
+        // A property that ends up back where it started is not notified at all.
+        // The batch belongs to the thread making the changes, it does not make setAge thread safe.
+        class batch_update
+        {
+            Person& person;
+        public:
+            explicit batch_update(Person& person)
+                : person{person}
+            {
+                ++person.batch_depth;
+            }
+
+            batch_update(const batch_update&) = delete;
+            batch_update& operator=(const batch_update&) = delete;
+
+            ~batch_update()
+            {
+                if(--person.batch_depth == 0)
+                {
+                    person.flush<Age>();
+                    person.flush<CanVote>();
+                }
+            }
+        };
+
         // A listener wants to be made aware of changes
         void subscribe(PersonListener* pl)
         {
-            lock_guard<mutex> guard{ mtx }; // Any other threads that try to lock this mtx will wait for this to unlock
-
-            if(find(begin(listeners), end(listeners), pl) == end(listeners)) // Prevent double subscription
-                listeners.push_back(pl);
+            listeners.subscribe(pl);
         }
 
         // A listener wants to stop being made aware of changes
         void unsubscribe(PersonListener* pl)
         {
-            lock_guard<mutex> guard{ mtx }; // thread safety
+            listeners.unsubscribe(pl);
+        }
 
-            for(auto it = listeners.begin(); it != listeners.end(); ++it)
-            {
-                if(*it == pl) // This is our PersonListener
-                {
-                    *it = nullptr; // will be removed in notify, more thread safe
-                }
-            }
+        // Or only of changes to a single property, p.subscribe<Age>(&listener)
+        template <typename Property>
+        void subscribe(PropertyListener<Property>* pl)
+        {
+            channel<Property>().subscribe(pl);
+        }
+
+        template <typename Property>
+        void unsubscribe(PropertyListener<Property>* pl)
+        {
+            channel<Property>().unsubscribe(pl);
         }
 
         // Let all listeners know a property has changed
         void notify(const string& property_name, const any new_value)
         {
-            lock_guard<mutex> guard{ mtx }; // thread safety
+            for(const auto listener : *listeners.snapshot())
+            {
+                listener->PersonChanged(*this, property_name, new_value);
+            }
+        }
 
-            for(const auto listener : listeners)
+        // Let the listeners of a single property know it has changed,
+        // no strings are built and nothing is boxed
+        template <typename Property>
+        void notify(const typename Property::type& new_value)
+        {
+            for(const auto listener : *channel<Property>().snapshot())
             {
-                if(listener) // check for nullptr
-                    listener->PersonChanged(*this, property_name, new_value);
+                listener->PropertyChanged(*this, new_value);
             }
-            // When listens unsubscribe they are set to nullptr, as its more thread safe. They can be removed here
-            listeners.erase(remove(listeners.begin(), listeners.end(), nullptr), listeners.end());
         }
 
     private:
         int age;
-        vector<PersonListener*> listeners;
+        // Each person has their own listeners, rather than sharing a lock with every other person
+        ListenerList<PersonListener> listeners;
+        // and a channel per property, found by type at compile time
+        tuple<ListenerList<PropertyListener<Age>>,
+              ListenerList<PropertyListener<CanVote>>> channels;
+
+        template <typename Property>
+        ListenerList<PropertyListener<Property>>& channel()
+        {
+            return get<ListenerList<PropertyListener<Property>>>(channels);
+        }
+
+        // A change held back by a batch_update, we remember the value from before
+        // the batch so we know if it really changed, and only keep the latest value
+        template <typename Property>
+        struct Pending
+        {
+            bool touched = false;
+            typename Property::type original{};
+            typename Property::type value{};
+        };
+
+        int batch_depth = 0;
+        tuple<Pending<Age>, Pending<CanVote>> pending;
+
+        template <typename Property>
+        void changed(const typename Property::type& old_value, const typename Property::type& new_value)
+        {
+            if(batch_depth > 0)
+            {   // Coalesce, later changes simply overwrite the value
+                auto& p = get<Pending<Property>>(pending);
+                if(!p.touched)
+                {
+                    p.touched = true;
+                    p.original = old_value;
+                }
+                p.value = new_value;
+                return;
+            }
+            publish<Property>(new_value);
+        }
+
+        template <typename Property>
+        void flush()
+        {
+            auto& p = get<Pending<Property>>(pending);
+            if(!p.touched) return;
+            p.touched = false;
+            if(p.value != p.original)
+                publish<Property>(p.value);
+        }
+
+        // Typed listeners are always told, the string + any listeners only
+        // pay for building their arguments when there are some to tell
+        template <typename Property>
+        void publish(const typename Property::type& new_value)
+        {
+            notify<Property>(new_value);
+            if(!listeners.snapshot()->empty())
+                notify(Property::name, new_value);
+        }
     };
 
     // Our console logger
@@ -139,22 +308,350 @@ namespace Observer
         }
     };
 
+    // The same logger using the typed channels, no string compares or any_cast needed
+    struct TypedConsoleListener : PropertyListener<Age>, PropertyListener<CanVote>
+    {
+        void PropertyChanged(Person& p, const int& new_value) override
+        {
+            cout << "person's age has been changed to " << new_value << endl;
+        }
+
+        void PropertyChanged(Person& p, const bool& new_value) override
+        {
+            cout << "person's can_vote has been changed to " << new_value << endl;
+        }
+    };
+
     // When using locks, its always important to consider deadlocks
     // Thats where two threads are waiting on each other to release the lock
-    struct BadListener : PersonListener
+    struct OneShotListener : PersonListener
     {
         void PersonChanged(Person& p, const string& property_name, const any new_value) override
         {
-            p.unsubscribe(this); // will cause a deadlock
+            p.unsubscribe(this); // safe, we only want to hear about the first change
 
-            // Whats actually going on here is.
+            // Had notify held the same lock as unsubscribe, this would deadlock.
             // 1. Notify was called, which takes a lock
             // 2. Which then calls PersonChanged (where we are now)
             // 3. We call to unsubscribe, which takes a lock
-            // Stop 3. is now waiting on the lock taken in step 1. Which will remain locked until we leave this method
-            // Deadlock
+            // Step 3. would wait on the lock taken in step 1, which remains locked until we leave this method
+            // As notify iterates over a snapshot without locking, unsubscribe is free to publish a new list
+            cout << "person's " << property_name << " changed, no longer listening" << endl;
+        }
+    };
+
+    // Counts notifications, so we can measure throughput without console output
+    struct CountingListener : PersonListener
+    {
+        std::atomic<size_t> count{ 0 };
 
-            
+        void PersonChanged(Person&, const string&, const any) override
+        {
+            count.fetch_add(1, memory_order_relaxed);
+        }
+    };
+
+    // So far every listener is called on the thread that called setAge,
+    // a slow listener makes setAge slow. Instead notifications can be queued
+    // and delivered by a pool of threads.
+
+    // A bounded queue that many threads can push to without locking.
+    // Each cell has a sequence number, which tells a thread whether the cell
+    // is free to write, ready to read, or that another thread got there first
+    template <typename T>
+    class BoundedQueue
+    {
+        struct Cell
+        {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        const size_t mask;
+        unique_ptr<Cell[]> cells;
+        std::atomic<size_t> enqueue_pos{ 0 };
+        std::atomic<size_t> dequeue_pos{ 0 };
+
+        // The positions are masked rather than divided, which only works for a power of two
+        static size_t round_up(size_t capacity)
+        {
+            size_t rounded = 2;
+            while(rounded < capacity)
+                rounded *= 2;
+            return rounded;
+        }
+    public:
+        explicit BoundedQueue(size_t capacity) // rounded up to a power of two
+            : mask{ round_up(capacity) - 1 },
+              cells{ new Cell[mask + 1] }
+        {
+            for(size_t i = 0; i <= mask; ++i)
+                cells[i].sequence.store(i, memory_order_relaxed);
+        }
+
+        bool try_push(const T& value)
+        {
+            auto pos = enqueue_pos.load(memory_order_relaxed);
+            for(;;)
+            {
+                auto& cell = cells[pos & mask];
+                const auto diff = static_cast<ptrdiff_t>(cell.sequence.load(memory_order_acquire) - pos);
+                if(diff == 0) // free, try to claim it
+                {
+                    if(enqueue_pos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+                    {
+                        cell.value = value;
+                        cell.sequence.store(pos + 1, memory_order_release); // ready to read
+                        return true;
+                    }
+                }
+                else if(diff < 0) // still holds an item from the last lap, we are full
+                {
+                    return false;
+                }
+                else // someone else claimed it
+                {
+                    pos = enqueue_pos.load(memory_order_relaxed);
+                }
+            }
+        }
+
+        bool try_pop(T& value)
+        {
+            auto pos = dequeue_pos.load(memory_order_relaxed);
+            for(;;)
+            {
+                auto& cell = cells[pos & mask];
+                const auto diff = static_cast<ptrdiff_t>(cell.sequence.load(memory_order_acquire) - (pos + 1));
+                if(diff == 0)
+                {
+                    if(dequeue_pos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+                    {
+                        value = cell.value;
+                        cell.sequence.store(pos + mask + 1, memory_order_release); // free for the next lap
+                        return true;
+                    }
+                }
+                else if(diff < 0) // empty
+                {
+                    return false;
+                }
+                else
+                {
+                    pos = dequeue_pos.load(memory_order_relaxed);
+                }
+            }
+        }
+
+        bool empty() const
+        {
+            const auto pos = dequeue_pos.load(memory_order_seq_cst);
+            return cells[pos & mask].sequence.load(memory_order_seq_cst) != pos + 1;
+        }
+    };
+
+    // Something with queued work for the pool
+    struct Drainable
+    {
+        virtual ~Drainable() = default;
+        virtual void drain() = 0;
+    };
+
+    // The thread pool. It only holds listeners that have something queued,
+    // each listener is in here at most once so only one thread drains it at a time
+    class AsyncDispatcher
+    {
+        mutex mtx;
+        condition_variable cv;
+        deque<Drainable*> ready;
+        bool stopping = false;
+        vector<thread> workers;
+    public:
+        explicit AsyncDispatcher(unsigned threads = max(1u, thread::hardware_concurrency()))
+        {
+            for(unsigned i = 0; i < threads; ++i)
+            {
+                workers.emplace_back([this]
+                {
+                    for(;;)
+                    {
+                        Drainable* d;
+                        {
+                            unique_lock<mutex> lock{ mtx };
+                            cv.wait(lock, [this] { return stopping || !ready.empty(); });
+                            if(ready.empty()) return; // stopping, and nothing left to do
+                            d = ready.front();
+                            ready.pop_front();
+                        }
+                        d->drain();
+                    }
+                });
+            }
+        }
+
+        ~AsyncDispatcher()
+        {
+            {
+                lock_guard<mutex> lock{ mtx };
+                stopping = true;
+            }
+            cv.notify_all();
+            for(auto& w : workers) w.join();
+        }
+
+        void schedule(Drainable* d)
+        {
+            {
+                lock_guard<mutex> lock{ mtx };
+                ready.push_back(d);
+            }
+            cv.notify_one();
+        }
+    };
+
+    // What happens when a listener falls so far behind its queue is full
+    enum class OverflowPolicy
+    {
+        Block,      // setAge waits for room, nothing is lost
+        DropOldest, // the oldest queued notification is thrown away
+        Coalesce    // keep only the latest value per person until the listener catches up
+    };
+
+    // Wraps a listener so it is called on the dispatcher's threads.
+    // Subscribe this to the person in place of the listener, p.subscribe<Age>(&async_listener).
+    // Notifications from a person reach the listener in the order they were made.
+    // The person must outlive any notifications still queued for it, and nobody
+    // may still be notifying this when it is destroyed.
+    template <typename Property>
+    class AsyncListener : public PropertyListener<Property>, Drainable
+    {
+        using value_type = typename Property::type;
+
+        struct Notification
+        {
+            Person* person;
+            value_type value;
+        };
+
+        PropertyListener<Property>& target;
+        AsyncDispatcher& dispatcher;
+        const OverflowPolicy policy;
+        BoundedQueue<Notification> queue;
+
+        // Only used when coalescing, once the queue has overflowed everything goes here
+        // until the listener has caught up, so a person's notifications stay in order
+        std::atomic<bool> overflowed{ false };
+        mutex overflow_mtx;
+        vector<Notification> overflow;
+
+        std::atomic<bool> scheduled{ false }; // are we in the dispatcher's ready list
+        std::atomic<int> active{ 0 };         // drains still to run, so we know when it's safe to go
+
+        static constexpr size_t max_per_drain = 64; // give other listeners a turn
+    public:
+        std::atomic<size_t> dropped{ 0 };
+
+        AsyncListener(PropertyListener<Property>& target,
+                      AsyncDispatcher& dispatcher,
+                      OverflowPolicy policy = OverflowPolicy::Block,
+                      size_t capacity = 1024)
+            : target{target},
+              dispatcher{dispatcher},
+              policy{policy},
+              queue{capacity}
+        {
+        }
+
+        ~AsyncListener()
+        {
+            while(active.load(memory_order_acquire) != 0) // let anything queued be delivered
+                this_thread::yield();
+        }
+
+        void PropertyChanged(Person& p, const value_type& new_value) override
+        {
+            push({ &p, new_value });
+
+            if(!scheduled.exchange(true))
+            {
+                active.fetch_add(1, memory_order_relaxed);
+                dispatcher.schedule(this);
+            }
+        }
+
+        void drain() override
+        {
+            size_t delivered = 0;
+            Notification n;
+            while(delivered < max_per_drain && queue.try_pop(n))
+            {
+                target.PropertyChanged(*n.person, n.value);
+                ++delivered;
+            }
+
+            // Caught up with the queue, now whatever was coalesced while it was full
+            if(delivered < max_per_drain && overflowed.load(memory_order_acquire))
+            {
+                vector<Notification> latest;
+                {
+                    lock_guard<mutex> lock{ overflow_mtx };
+                    swap(latest, overflow);
+                    overflowed.store(false, memory_order_release);
+                }
+                for(auto& o : latest)
+                    target.PropertyChanged(*o.person, o.value);
+            }
+
+            scheduled.store(false);
+            if((!queue.empty() || overflowed.load()) && !scheduled.exchange(true))
+            {   // More arrived while we were busy, go to the back of the line
+                dispatcher.schedule(this);
+                return;
+            }
+            active.fetch_sub(1, memory_order_release); // the last thing we touch
+        }
+
+    private:
+        void push(const Notification& n)
+        {
+            if(!overflowed.load(memory_order_acquire) && queue.try_push(n))
+                return;
+
+            switch(policy)
+            {
+                case OverflowPolicy::Block:
+                    while(!queue.try_push(n))
+                        this_thread::yield();
+                    break;
+                case OverflowPolicy::DropOldest:
+                {
+                    Notification oldest;
+                    while(!queue.try_push(n))
+                    {
+                        if(queue.try_pop(oldest))
+                            dropped.fetch_add(1, memory_order_relaxed);
+                    }
+                    break;
+                }
+                case OverflowPolicy::Coalesce:
+                {
+                    lock_guard<mutex> lock{ overflow_mtx };
+                    auto it = find_if(begin(overflow), end(overflow),
+                                      [&](const Notification& o) { return o.person == n.person; });
+                    if(it != end(overflow))
+                    {
+                        it->value = n.value; // replace, the listener only needs the latest
+                        dropped.fetch_add(1, memory_order_relaxed);
+                    }
+                    else
+                    {
+                        overflow.push_back(n);
+                    }
+                    overflowed.store(true, memory_order_release);
+                    break;
+                }
+                default: break;
+            }
         }
     };
 
@@ -176,8 +673,163 @@ int Observer_main(int argc, char* argv[])
     p.unsubscribe(&cl);
     p.setAge(17); // Should not be notified
 
+    OneShotListener osl;
+    p.subscribe(&osl);
+    p.setAge(18); // Notified, then unsubscribes itself
+    p.setAge(19); // Should not be notified
+
+    TypedConsoleListener tcl;
+    p.subscribe<Age>(&tcl); // Listen to each property we are interested in
+    p.subscribe<CanVote>(&tcl);
+    p.setAge(10); // Notified of both, with the values as int and bool
+    p.unsubscribe<CanVote>(&tcl);
+    p.setAge(20); // Only notified of age
+    p.subscribe<CanVote>(&tcl);
+
+    {
+        Person::batch_update batch{ p }; // Hold back notifications until the end of the scope
+        p.setAge(12);
+        p.setAge(15);
+        p.setAge(30);
+    } // Notified once, age is now 30. can_vote went false then true again so its not notified
+
+    {
+        Person::batch_update batch{ p };
+        p.setAge(31);
+        p.setAge(30);
+    } // Nothing actually changed, no notifications
+
 	getchar();
 	return EXIT_SUCCESS;
 }
 
+// Many people each with many listeners, updated from several threads at once.
+// Another thread keeps subscribing and unsubscribing to force new snapshots.
+int Observer_Benchmark_main(int argc, char* argv[])
+{
+    const size_t people_per_thread = 64;
+    const size_t listeners_per_person = 8;
+    const size_t updates_per_thread = 200000;
+    const auto max_threads = max(1u, thread::hardware_concurrency());
+
+    for(unsigned threads = 1; threads <= max_threads; threads *= 2)
+    {
+        vector<unique_ptr<Person>> people;
+        vector<unique_ptr<CountingListener>> counters;
+        for(size_t i = 0; i < threads * people_per_thread; ++i)
+        {
+            people.push_back(make_unique<Person>(0));
+            for(size_t j = 0; j < listeners_per_person; ++j)
+            {
+                counters.push_back(make_unique<CountingListener>());
+                people.back()->subscribe(counters.back().get());
+            }
+        }
+
+        std::atomic<bool> done{ false };
+        thread churn{ [&]
+        {
+            CountingListener churner;
+            while(!done.load(memory_order_relaxed))
+            {
+                for(auto& p : people) p->subscribe(&churner);
+                for(auto& p : people) p->unsubscribe(&churner);
+            }
+        } };
 
+        const auto start = chrono::steady_clock::now();
+        vector<thread> workers;
+        for(unsigned t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&, t]
+            {
+                const auto first = t * people_per_thread;
+                for(size_t i = 0; i < updates_per_thread; ++i)
+                {
+                    people[first + i % people_per_thread]->setAge(static_cast<int>(i % 32)); // crosses 16, so can_vote fires too
+                }
+            });
+        }
+        for(auto& w : workers) w.join();
+        const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+        done = true;
+        churn.join();
+
+        size_t notifications = 0;
+        for(auto& c : counters) notifications += c->count;
+
+        cout << threads << " thread(s): "
+             << static_cast<size_t>(notifications / elapsed.count()) << " notifications/sec" << endl;
+    }
+
+    getchar();
+    return EXIT_SUCCESS;
+}
+
+// A listener that takes a while, setAge shouldn't have to wait for it
+struct SlowListener : PropertyListener<Age>
+{
+    size_t count = 0;
+    int last = 0;
+
+    void PropertyChanged(Person&, const int& new_value) override
+    {
+        const auto until = chrono::steady_clock::now() + chrono::microseconds{ 20 };
+        while(chrono::steady_clock::now() < until) {} // pretend to do some work
+        last = new_value;
+        ++count;
+    }
+};
+
+// Times every setAge, printing the average and the worst
+void time_setters(const string& name, PropertyListener<Age>& listener, int updates)
+{
+    Person p{ 0 };
+    p.subscribe<Age>(&listener);
+
+    chrono::nanoseconds total{ 0 }, worst{ 0 };
+    for(int i = 1; i <= updates; ++i)
+    {
+        const auto start = chrono::steady_clock::now();
+        p.setAge(i);
+        const auto taken = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start);
+        total += taken;
+        worst = max(worst, taken);
+    }
+    p.unsubscribe<Age>(&listener);
+
+    cout << name << ": setAge average " << total.count() / updates << "ns, worst " << worst.count() << "ns";
+}
+
+int Observer_Async_Benchmark_main(int argc, char* argv[])
+{
+    const int updates = 20000;
+
+    {
+        SlowListener slow;
+        time_setters("sync", slow, updates);
+        cout << ", delivered " << slow.count << endl;
+    }
+
+    const pair<string, OverflowPolicy> policies[]{
+        { "block", OverflowPolicy::Block },
+        { "drop oldest", OverflowPolicy::DropOldest },
+        { "coalesce", OverflowPolicy::Coalesce }
+    };
+    for(auto& policy : policies)
+    {
+        SlowListener slow;
+        AsyncDispatcher dispatcher{ 2 };
+        size_t dropped;
+        {
+            AsyncListener<Age> async{ slow, dispatcher, policy.second, 256 };
+            time_setters(policy.first, async, updates);
+            dropped = async.dropped;
+        } // waits for the queue to be drained
+        cout << ", delivered " << slow.count << ", dropped " << dropped << ", last age " << slow.last << endl;
+    }
+
+    getchar();
+    return EXIT_SUCCESS;
+}
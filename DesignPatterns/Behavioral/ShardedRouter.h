@@ -0,0 +1,180 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace Sharded_Router
+{
+    // A bounded queue for exactly one producer thread and one consumer thread.
+    // Each side only writes its own index, so neither ever waits on a lock or
+    // fights over a compare-and-swap. Each side also keeps a copy of the other's
+    // index and only reads the shared one when the copy says full/empty.
+    template <typename T>
+    class SpscQueue
+    {
+        const std::size_t mask;
+        std::unique_ptr<T[]> items;
+
+        // Kept on their own cache lines so the two threads don't keep stealing them from each other
+        alignas(64) std::atomic<std::size_t> head{ 0 }; // next to read, written by the consumer
+        std::size_t cached_tail = 0;
+        alignas(64) std::atomic<std::size_t> tail{ 0 }; // next to write, written by the producer
+        std::size_t cached_head = 0;
+
+        // The indexes are masked rather than divided, which only works for a power of two
+        static std::size_t round_up(std::size_t capacity)
+        {
+            std::size_t rounded = 2;
+            while(rounded < capacity)
+                rounded *= 2;
+            return rounded;
+        }
+    public:
+        explicit SpscQueue(std::size_t capacity) // rounded up to a power of two
+            : mask{ round_up(capacity) - 1 },
+              items{ new T[mask + 1] }
+        {
+        }
+
+        // Producer only
+        bool try_push(const T& item)
+        {
+            const auto t = tail.load(std::memory_order_relaxed);
+            if(t - cached_head > mask)
+            {
+                cached_head = head.load(std::memory_order_acquire);
+                if(t - cached_head > mask)
+                    return false; // full
+            }
+            items[t & mask] = item;
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer only, takes up to max items, returns how many
+        std::size_t pop(T* out, std::size_t max)
+        {
+            const auto h = head.load(std::memory_order_relaxed);
+            if(cached_tail == h)
+            {
+                cached_tail = tail.load(std::memory_order_acquire);
+                if(cached_tail == h)
+                    return 0; // empty
+            }
+            const auto available = cached_tail - h;
+            const auto n = available < max ? available : max;
+            for(std::size_t i = 0; i < n; ++i)
+                out[i] = items[(h + i) & mask];
+            head.store(h + n, std::memory_order_release);
+            return n;
+        }
+    };
+
+    // Spreads messages for many things, state machines, bank accounts..., over several threads.
+    // Each thing has a key and belongs to one shard (key % shards), and each shard has its own
+    // thread and its own Worker, so no two threads ever touch the same thing.
+    // Every producer has its own single producer queue into every shard, which keeps
+    // a producer's messages for a key in the order it posted them.
+    // The shard's thread calls worker(messages, count) with each batch it takes off a queue
+    template <typename Message, typename Worker>
+    class ShardedRouter
+    {
+        static constexpr std::size_t batch_size = 256;
+
+        struct Shard
+        {
+            std::vector<std::unique_ptr<SpscQueue<Message>>> ingress; // one per producer
+            Worker worker;
+            std::thread thread;
+
+            explicit Shard(Worker&& worker)
+                : worker{ std::move(worker) }
+            {
+            }
+        };
+
+        std::vector<std::unique_ptr<Shard>> shards;
+        std::atomic<bool> stopping{ false };
+
+        void run(Shard& shard)
+        {
+            Message received[batch_size];
+            for(;;)
+            {
+                // Only give up once a pass after stop() finds nothing, so nothing posted before it is lost
+                const bool last_pass = stopping.load(std::memory_order_acquire);
+                bool any = false;
+
+                for(auto& queue : shard.ingress)
+                {
+                    const auto n = queue->pop(received, batch_size);
+                    if(n == 0) continue;
+                    any = true;
+                    shard.worker(received, n);
+                }
+
+                if(!any)
+                {
+                    if(last_pass) return;
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+    public:
+        // make_worker(s) makes the worker for shard number s, queue_capacity is rounded up to a power of two
+        template <typename MakeWorker>
+        ShardedRouter(std::size_t producers, std::size_t shard_count, MakeWorker make_worker, std::size_t queue_capacity = 4096)
+        {
+            for(std::size_t s = 0; s < shard_count; ++s)
+            {
+                shards.push_back(std::make_unique<Shard>(make_worker(s)));
+                for(std::size_t p = 0; p < producers; ++p)
+                    shards.back()->ingress.push_back(std::make_unique<SpscQueue<Message>>(queue_capacity));
+            }
+            for(auto& shard : shards)
+            {
+                auto& s = *shard;
+                s.thread = std::thread{ [this, &s] { run(s); } };
+            }
+        }
+
+        ShardedRouter(const ShardedRouter&) = delete;
+        ShardedRouter& operator=(const ShardedRouter&) = delete;
+
+        ~ShardedRouter()
+        {
+            stop();
+        }
+
+        std::size_t shard_count() const
+        {
+            return shards.size();
+        }
+
+        // Only ever called by producer number `producer`'s own thread
+        void post(std::size_t producer, std::size_t key, const Message& m)
+        {
+            auto& queue = *shards[key % shards.size()]->ingress[producer];
+            while(!queue.try_push(m))
+                std::this_thread::yield(); // the shard is behind, wait for room
+        }
+
+        // Call once the producers have finished, everything they posted is handled before this returns
+        void stop()
+        {
+            stopping.store(true, std::memory_order_release);
+            for(auto& shard : shards)
+                if(shard->thread.joinable())
+                    shard->thread.join();
+        }
+
+        // Only once stopped
+        const Worker& worker(std::size_t shard) const
+        {
+            return shards[shard]->worker;
+        }
+    };
+}
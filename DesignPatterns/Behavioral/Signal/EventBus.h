@@ -0,0 +1,76 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "Signal.h"
+
+namespace Signals
+{
+    // One signal carrying every kind of event makes every handler look at every event,
+    // and work out with a dynamic_cast whether it cares. Here each event type gets a small
+    // number the first time it is used, and that number picks its own signal out of a table,
+    // so publishing an event only ever reaches the handlers for exactly that type.
+    // Like Signal, the Policy says how thread safe the signals are. Subscribing to a
+    // type for the first time grows the table, so do that before publishing from other threads
+    template <typename Policy = NoLock>
+    class EventBus
+    {
+        template <typename E>
+        using Handlers = Signal<void(const E&), Policy>;
+
+        std::vector<std::unique_ptr<detail::SignalBase>> handlers; // indexed by event_id<E>()
+
+        static std::size_t next_id()
+        {
+            static std::atomic<std::size_t> next{ 0 };
+            return next++;
+        }
+
+        template <typename E>
+        static std::size_t event_id()
+        {
+            static const std::size_t id = next_id();
+            return id;
+        }
+
+        template <typename E>
+        Handlers<E>* find() const
+        {
+            const auto id = event_id<E>();
+            if(id >= handlers.size() || !handlers[id])
+                return nullptr;
+            return static_cast<Handlers<E>*>(handlers[id].get()); // the id says what it is
+        }
+    public:
+        EventBus() = default;
+        EventBus(const EventBus&) = delete;
+        EventBus& operator=(const EventBus&) = delete;
+
+        template <typename E>
+        connection subscribe(std::function<void(const E&)> handler)
+        {
+            const auto id = event_id<E>();
+            if(id >= handlers.size())
+                handlers.resize(id + 1);
+            if(!handlers[id])
+                handlers[id] = std::make_unique<Handlers<E>>();
+            return static_cast<Handlers<E>&>(*handlers[id]).connect(std::move(handler));
+        }
+
+        template <typename E>
+        void publish(const E& e) const
+        {
+            if(auto h = find<E>())
+                (*h)(e);
+        }
+
+        template <typename E>
+        std::size_t num_handlers() const
+        {
+            const auto h = find<E>();
+            return h ? h->num_slots() : 0;
+        }
+    };
+}
@@ -0,0 +1,365 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Signals
+{
+    // boost::signals2 is thread safe whether we need it or not, every emit takes a mutex
+    // and allocates to keep track of the slots it is calling. Here the caller chooses what
+    // they need, as a threading policy:
+    // - NoLock, single threaded, costs nothing
+    // - SpinLock, a short lock around the bookkeeping, never held while slots are called
+    // - Rcu, emit works on a snapshot of the slots and never waits, connecting copies the slots
+
+    struct NoLock
+    {
+        void lock() {}
+        void unlock() {}
+    };
+
+    class SpinLock
+    {
+        std::atomic_flag flag = ATOMIC_FLAG_INIT;
+    public:
+        void lock()
+        {
+            while(flag.test_and_set(std::memory_order_acquire))
+                std::this_thread::yield();
+        }
+
+        void unlock()
+        {
+            flag.clear(std::memory_order_release);
+        }
+    };
+
+    struct Rcu {};
+
+    namespace detail
+    {
+        // So a connection doesn't need to know the signal's type
+        struct SignalBase
+        {
+            virtual ~SignalBase() = default;
+            virtual void disconnect(std::uint64_t id) = 0;
+        };
+    }
+
+    // A handle to a connected slot, just a pointer and an id.
+    // The signal must outlive any use of its connections.
+    class connection
+    {
+        detail::SignalBase* signal = nullptr;
+        std::uint64_t id = 0;
+    public:
+        connection() = default;
+
+        connection(detail::SignalBase* signal, std::uint64_t id)
+            : signal{signal},
+              id{id}
+        {
+        }
+
+        bool connected() const
+        {
+            return signal != nullptr;
+        }
+
+        void disconnect()
+        {
+            if(signal)
+                signal->disconnect(id);
+            signal = nullptr;
+        }
+    };
+
+    template <typename Signature, typename Policy = NoLock, std::size_t InlineSlots = 4>
+    class Signal;
+
+    // The first InlineSlots slots live inside the signal itself, only more than that go to the heap.
+    // Slots may connect or disconnect while the signal is emitting, even from inside a slot:
+    // new slots wait until the emit has finished, disconnected slots are skipped and tidied up after.
+    template <typename... Args, typename Policy, std::size_t InlineSlots>
+    class Signal<void(Args...), Policy, InlineSlots> : public detail::SignalBase
+    {
+        // Copyable so slots can be moved around, atomic so a slot can be
+        // disconnected on one thread while another is emitting
+        struct Flag
+        {
+            std::atomic<bool> value{ true };
+
+            Flag() = default;
+            Flag(const Flag& other)
+                : value{ other.value.load(std::memory_order_relaxed) }
+            {
+            }
+
+            Flag& operator=(const Flag& other)
+            {
+                value.store(other.value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                return *this;
+            }
+        };
+
+        struct Slot
+        {
+            std::uint64_t id = 0;
+            std::function<void(Args...)> fn;
+            Flag connected;
+        };
+
+        Slot inline_slots[InlineSlots];
+        std::size_t inline_count = 0;
+        std::vector<Slot> spilled;  // once the inline slots are used up
+        std::vector<Slot> pending;  // connected while emitting
+
+        mutable Policy lock;
+        int emitting = 0;  // how many emits are in progress, the slots can't move while this is non zero
+        bool dirty = false;  // something to tidy once nobody is emitting
+        std::uint64_t next_id = 1;
+
+        using guard = std::lock_guard<Policy>;
+
+        // Keeps emitting right even if a slot throws
+        struct EmitScope
+        {
+            Signal& signal;
+
+            explicit EmitScope(Signal& signal)
+                : signal{signal}
+            {
+                guard g{ signal.lock };
+                ++signal.emitting;
+            }
+
+            ~EmitScope()
+            {
+                guard g{ signal.lock };
+                if(--signal.emitting == 0 && signal.dirty)
+                    signal.tidy();
+            }
+        };
+
+        void append(Slot&& slot)
+        {
+            if(inline_count < InlineSlots)
+                inline_slots[inline_count++] = std::move(slot);
+            else
+                spilled.push_back(std::move(slot));
+        }
+
+        // Only called with the lock held and nobody emitting
+        void tidy()
+        {
+            std::vector<Slot> keep;
+            for(auto& s : spilled)
+                if(s.connected.value.load(std::memory_order_relaxed))
+                    keep.push_back(std::move(s));
+            for(auto& s : pending)
+                if(s.connected.value.load(std::memory_order_relaxed))
+                    keep.push_back(std::move(s));
+            spilled.clear();
+            pending.clear();
+
+            std::size_t count = 0;
+            for(std::size_t i = 0; i < inline_count; ++i)
+            {
+                if(inline_slots[i].connected.value.load(std::memory_order_relaxed))
+                {
+                    if(i != count)
+                        inline_slots[count] = std::move(inline_slots[i]);
+                    ++count;
+                }
+            }
+            for(std::size_t i = count; i < inline_count; ++i)
+                inline_slots[i] = Slot{}; // let go of anything the lambdas captured
+            inline_count = count;
+
+            for(auto& s : keep)
+                append(std::move(s));
+            dirty = false;
+        }
+
+    public:
+        Signal() = default;
+        Signal(const Signal&) = delete;
+        Signal& operator=(const Signal&) = delete;
+
+        connection connect(std::function<void(Args...)> fn)
+        {
+            guard g{ lock };
+            Slot slot;
+            slot.id = next_id++;
+            slot.fn = std::move(fn);
+            const auto id = slot.id;
+
+            if(emitting)
+            {
+                pending.push_back(std::move(slot));
+                dirty = true;
+            }
+            else
+            {
+                append(std::move(slot));
+            }
+            return { this, id };
+        }
+
+        void disconnect(std::uint64_t id) override
+        {
+            guard g{ lock };
+            const auto mark = [&](Slot& s)
+            {
+                if(s.id == id)
+                {
+                    s.connected.value.store(false, std::memory_order_relaxed);
+                    dirty = true;
+                }
+            };
+            for(std::size_t i = 0; i < inline_count; ++i) mark(inline_slots[i]);
+            for(auto& s : spilled) mark(s);
+            for(auto& s : pending) mark(s);
+
+            if(!emitting && dirty)
+                tidy();
+        }
+
+        void disconnect_all_slots()
+        {
+            guard g{ lock };
+            for(std::size_t i = 0; i < inline_count; ++i)
+                inline_slots[i].connected.value.store(false, std::memory_order_relaxed);
+            for(auto& s : spilled) s.connected.value.store(false, std::memory_order_relaxed);
+            for(auto& s : pending) s.connected.value.store(false, std::memory_order_relaxed);
+            dirty = true;
+
+            if(!emitting)
+                tidy();
+        }
+
+        bool empty() const
+        {
+            return num_slots() == 0;
+        }
+
+        // Slots that are connected now, including ones connected during an emit that
+        // haven't been moved in yet, and not ones disconnected that haven't been tidied away
+        std::size_t num_slots() const
+        {
+            guard g{ lock };
+            std::size_t count = 0;
+            const auto live = [&](const Slot& s)
+            {
+                if(s.connected.value.load(std::memory_order_relaxed))
+                    ++count;
+            };
+            for(std::size_t i = 0; i < inline_count; ++i) live(inline_slots[i]);
+            for(auto& s : spilled) live(s);
+            for(auto& s : pending) live(s);
+            return count;
+        }
+
+        // Emit, calling every connected slot in the order they were connected
+        void operator()(const Args&... args)
+        {
+            EmitScope scope{ *this };
+
+            // Nobody may move the slots while we are emitting, so we can walk them without the lock
+            for(std::size_t i = 0; i < inline_count; ++i)
+            {
+                auto& s = inline_slots[i];
+                if(s.connected.value.load(std::memory_order_relaxed))
+                    s.fn(args...);
+            }
+            for(std::size_t i = 0; i < spilled.size(); ++i)
+            {
+                auto& s = spilled[i];
+                if(s.connected.value.load(std::memory_order_relaxed))
+                    s.fn(args...);
+            }
+        }
+    };
+
+    // Read-copy-update, emit takes a snapshot of the slots without waiting on anyone.
+    // A slot disconnected during an emit may still be called by that emit.
+    template <typename... Args, std::size_t InlineSlots>
+    class Signal<void(Args...), Rcu, InlineSlots> : public detail::SignalBase
+    {
+        struct Slot
+        {
+            std::uint64_t id;
+            std::function<void(Args...)> fn;
+        };
+        using Slots = std::vector<Slot>;
+
+        std::shared_ptr<const Slots> slots = std::make_shared<const Slots>();
+        std::mutex writer_mtx; // only connect/disconnect wait on each other
+        std::uint64_t next_id = 1;
+
+        template <typename Change>
+        void update(Change change)
+        {
+            auto updated = std::make_shared<Slots>(*std::atomic_load(&slots));
+            change(*updated);
+            std::atomic_store(&slots, std::shared_ptr<const Slots>{ std::move(updated) });
+        }
+
+    public:
+        Signal() = default;
+        Signal(const Signal&) = delete;
+        Signal& operator=(const Signal&) = delete;
+
+        connection connect(std::function<void(Args...)> fn)
+        {
+            std::lock_guard<std::mutex> g{ writer_mtx };
+            const auto id = next_id++;
+            update([&](Slots& s) { s.push_back({ id, std::move(fn) }); });
+            return { this, id };
+        }
+
+        void disconnect(std::uint64_t id) override
+        {
+            std::lock_guard<std::mutex> g{ writer_mtx };
+            update([&](Slots& s)
+            {
+                for(auto it = s.begin(); it != s.end(); ++it)
+                {
+                    if(it->id == id)
+                    {
+                        s.erase(it);
+                        break;
+                    }
+                }
+            });
+        }
+
+        void disconnect_all_slots()
+        {
+            std::lock_guard<std::mutex> g{ writer_mtx };
+            std::atomic_store(&slots, std::make_shared<const Slots>());
+        }
+
+        bool empty() const
+        {
+            return num_slots() == 0;
+        }
+
+        std::size_t num_slots() const
+        {
+            return std::atomic_load(&slots)->size();
+        }
+
+        void operator()(const Args&... args)
+        {
+            const auto snapshot = std::atomic_load(&slots);
+            for(auto& s : *snapshot)
+                s.fn(args...);
+        }
+    };
+}
@@ -0,0 +1,49 @@
+#define _SCL_SECURE_NO_WARNINGS // boost compile errors
+#include <iostream>
+#include <string>
+#include <chrono>
+using namespace std;
+#include <boost/signals2.hpp>
+#include "Signal.h"
+
+namespace Signal_Benchmark
+{
+    // How long does an emit take, with our signals against boost::signals2
+
+    unsigned total = 0; // the slots do a little work so they aren't optimized away
+
+    template <typename TSignal>
+    double nanoseconds_per_emit(size_t slots, size_t emits)
+    {
+        TSignal signal;
+        for(size_t i = 0; i < slots; ++i)
+            signal.connect([](int x) { total += x; });
+
+        const auto start = chrono::steady_clock::now();
+        for(size_t i = 0; i < emits; ++i)
+            signal(static_cast<int>(i));
+        const chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+        return elapsed.count() / emits;
+    }
+}
+
+using namespace Signal_Benchmark;
+
+int Signal_Benchmark_main(int argc, char* argv[])
+{
+    const size_t emits = 1000000;
+
+    for(size_t slots : { 0, 1, 8, 64 })
+    {
+        const auto scaled = slots > 8 ? emits / 8 : emits; // keep the big runs short
+        cout << slots << " slot(s)" << endl
+             << "  signals2: " << nanoseconds_per_emit<boost::signals2::signal<void(int)>>(slots, scaled) << "ns" << endl
+             << "  no lock:  " << nanoseconds_per_emit<Signals::Signal<void(int)>>(slots, scaled) << "ns" << endl
+             << "  spinlock: " << nanoseconds_per_emit<Signals::Signal<void(int), Signals::SpinLock>>(slots, scaled) << "ns" << endl
+             << "  rcu:      " << nanoseconds_per_emit<Signals::Signal<void(int), Signals::Rcu>>(slots, scaled) << "ns" << endl;
+    }
+    cout << "(" << total << ")" << endl;
+
+    getchar();
+    return EXIT_SUCCESS;
+}
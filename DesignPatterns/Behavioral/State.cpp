@@ -1,8 +1,8 @@
 #include <iostream>
 #include <string>
 #include <vector>
-#include <map>
 using namespace std;
+#include "State_Table/Phone.h"
 
 namespace State_Pattern
 {
@@ -26,140 +26,51 @@ namespace State_Pattern
     // construct which manages states and transitions is called a
     // state machine.
 
-    // Lets use the phone example, we need to know the current state of the phone
-    enum class State
-    {
-        OffHook,
-        Connecting,
-        Connected,
-        OnHold
-    };
-
-    // So we can output to the console
-    inline ostream& operator<<(ostream& os, const State& s)
-    {
-        switch(s)
-        {
-            case State::OffHook:
-                os << "off the hook";
-                break;
-            case State::Connecting:
-                os << "connecting";
-                break;
-            case State::Connected:
-                os << "connected";
-                break;
-            case State::OnHold:
-                os << "on hold";
-                break;
-            default: break;
-        }
-        return os;
-    }
-
-    // Now we need something that will cause the state to change
-    enum class Trigger
-    {
-        CallDialed,
-        HungUp,
-        CallConnected,
-        PlacedOnHold,
-        TakenOffHold,
-        LeftMessage
-    };
-
-    // again so we can output to the console
-    inline ostream& operator<<(ostream& os, const Trigger& t)
-    {
-        switch(t)
-        {
-            case Trigger::CallDialed:
-                os << "call dialed";
-                break;
-            case Trigger::HungUp:
-                os << "hung up";
-                break;
-            case Trigger::CallConnected:
-                os << "call connected";
-                break;
-            case Trigger::PlacedOnHold:
-                os << "placed on hold";
-                break;
-            case Trigger::TakenOffHold:
-                os << "taken off hold";
-                break;
-            case Trigger::LeftMessage:
-                os << "left message";
-                break;
-            default: break;
-        }
-        return os;
-    }
+    // Lets use the phone example. Its states, triggers and the rules
+    // that link them are in State_Table/Phone.h, so other examples can share them
 }
 
 using namespace State_Pattern;
 
 int State_Pattern_main(int argc, char* argv[])
 {
-    // Now we can map out all of the states, along 
-    // with what triggers are available and which
-    // state that trigger will lead to.
-    map<State, vector<pair<Trigger, State>>> rules;
-
-    // The phone is off the hood. So we can dial,
-    // which will lead to connecting
-    rules[State::OffHook] = {
-        { Trigger::CallDialed, State::Connecting }
-    };
-
-    // While the phone is connecting, we can either
-    // Hang up to return to the OffHook state or,
-    // The call can be connected, which leads to
-    // the connected state
-    rules[State::Connecting] = {
-        { Trigger::HungUp, State::OffHook },
-        { Trigger::CallConnected, State::Connected }
-    };
-
-    rules[State::Connected] = {
-        { Trigger::LeftMessage, State::OffHook },
-        { Trigger::HungUp, State::OffHook },
-        { Trigger::PlacedOnHold, State::OnHold }
-    };
-
-    rules[State::OnHold] = {
-        { Trigger::TakenOffHold, State::Connected },
-        { Trigger::HungUp, State::OffHook },
-    };
+    // The rules were compiled into a table, phone_table.fire(state, trigger)
+    // gives us the next state in one lookup
 
     // Lets state with the phone off the hook
     State currentState{ State::OffHook };
 
-    while(true) // Infinate loop
+    cout << "The phone is currently " << currentState << endl;
+
+    // Keep asking which trigger to use, which in turn changes the state.
+    // Stops when there's no more input, so triggers can also be piped in from a script
+    while(true)
     {
-        // So we can display the currentState, and using the map
-        // ask which trigger to use, which in turn changes the state.
-        cout << "The phone is currently " << currentState << endl;
-    
-        
-select_trigger: // Avoid using triggers/goto. 
         cout << "Select a trigger: " << endl;
 
+        // Listed in the order the rules were written, as they always have been
+        vector<Trigger> triggers;
+        for(auto& rule : phone_rules)
+            if(rule.from == currentState)
+                triggers.push_back(rule.trigger);
         int i = 0;
-        for(auto& item : rules[currentState])
+        for(auto& trigger : triggers)
         {
-            cout << i++ << ". " << item.first << endl;
+            cout << i++ << ". " << trigger << endl;
         }
 
         int input;
-        cin >> input;
-        if(input < 0 || (input+1) > rules[currentState].size())
+        if(!(cin >> input))
+            break;
+
+        if(input < 0 || input >= static_cast<int>(triggers.size()))
         {
             cout << "Incorrect option. Please try again." << endl;
-            goto select_trigger; // Just to simlify the approach use the trigger
+            continue;
         }
 
-        currentState = rules[currentState][input].second;
+        currentState = phone_table.fire(currentState, triggers[input]);
+        cout << "The phone is currently " << currentState << endl;
     }
 
     cout << "We are done using the phone." << endl;
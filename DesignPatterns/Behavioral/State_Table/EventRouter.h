@@ -0,0 +1,89 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "MachineRunner.h"
+#include "../ShardedRouter.h"
+
+namespace State_Table
+{
+    // Spreads events for many machines over several threads.
+    // Each machine belongs to one shard (machine % shards), and each shard has its own
+    // thread and its own MachineRunner, so no two threads ever touch the same state.
+    // The queues and threads are a ShardedRouter, this just says what a shard does with its events
+    template <typename Table>
+    class EventRouter
+    {
+        using State = typename Table::state_type;
+        using Trigger = typename Table::trigger_type;
+        using Runner = MachineRunner<Table>;
+    public:
+        struct Event
+        {
+            std::uint32_t machine;
+            Trigger trigger;
+        };
+
+    private:
+        // The machines with this shard's number, its machine i is machine i * shard_count + the shard
+        struct Shard
+        {
+            Runner runner;
+            std::size_t shard_count;
+            std::vector<typename Runner::Event> batch;
+
+            void operator()(const Event* events, std::size_t n)
+            {
+                batch.clear();
+                for(std::size_t i = 0; i < n; ++i)
+                    batch.push_back({ static_cast<std::uint32_t>(events[i].machine / shard_count), events[i].trigger });
+                runner.apply(batch);
+            }
+        };
+
+        const std::size_t machines;
+        Sharded_Router::ShardedRouter<Event, Shard> router;
+
+    public:
+        EventRouter(const Table& table, std::size_t machines, State initial,
+                    std::size_t producers, std::size_t shard_count, std::size_t queue_capacity = 4096) // rounded up to a power of two
+            : machines{ machines },
+              router{ producers, shard_count, [&](std::size_t s)
+              {
+                  const auto owned = (machines + shard_count - 1 - s) / shard_count;
+                  return Shard{ Runner{ table, owned, initial }, shard_count, {} };
+              }, queue_capacity }
+        {
+        }
+
+        // Only ever called by producer number `producer`'s own thread.
+        // False if there's no such machine
+        bool post(std::size_t producer, const Event& e)
+        {
+            if(e.machine >= machines)
+                return false;
+            router.post(producer, e.machine, e);
+            return true;
+        }
+
+        // Call once the producers have finished, everything they posted is applied before this returns
+        void stop()
+        {
+            router.stop();
+        }
+
+        // Only once stopped
+        State state(std::uint32_t machine) const
+        {
+            return router.worker(machine % router.shard_count()).runner.state(machine / router.shard_count());
+        }
+
+        std::uint64_t transition_count(State from, State to) const
+        {
+            std::uint64_t total = 0;
+            for(std::size_t s = 0; s < router.shard_count(); ++s)
+                total += router.worker(s).runner.transition_count(from, to);
+            return total;
+        }
+    };
+}
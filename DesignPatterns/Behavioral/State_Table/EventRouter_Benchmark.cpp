@@ -0,0 +1,87 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <thread>
+using namespace std;
+#include "Phone.h"
+#include "EventRouter.h"
+
+namespace EventRouter_Benchmark
+{
+    using Router = State_Table::EventRouter<State_Pattern::PhoneTable>;
+
+    // Each producer's events are made up front, so we time the routing and not the random numbers
+    vector<vector<Router::Event>> generate(size_t producers, size_t events_each, size_t machines)
+    {
+        vector<vector<Router::Event>> load(producers);
+        for(size_t p = 0; p < producers; ++p)
+        {
+            mt19937 rng{ static_cast<unsigned>(p) };
+            uniform_int_distribution<uint32_t> machine{ 0, static_cast<uint32_t>(machines - 1) };
+            uniform_int_distribution<int> trigger{ 0, static_cast<int>(State_Pattern::trigger_count) - 1 };
+            load[p].resize(events_each);
+            for(auto& e : load[p])
+                e = { machine(rng), static_cast<State_Pattern::Trigger>(trigger(rng)) };
+        }
+        return load;
+    }
+}
+
+using namespace State_Pattern;
+using namespace EventRouter_Benchmark;
+
+int EventRouter_Benchmark_main(int argc, char* argv[])
+{
+    const size_t machines = 1000000;
+    const size_t events_each = 2000000;
+    const size_t cores = max(2u, thread::hardware_concurrency());
+    const size_t producers = max<size_t>(1, cores / 2);
+
+    const auto load = generate(producers, events_each, machines);
+
+    for(size_t shards = 1; shards <= cores; shards *= 2)
+    {
+        const auto start = chrono::steady_clock::now();
+        Router router{ phone_table, machines, State::OffHook, producers, shards };
+
+        vector<thread> threads;
+        for(size_t p = 0; p < producers; ++p)
+        {
+            threads.emplace_back([&, p]
+            {
+                for(auto& e : load[p])
+                    router.post(p, e);
+            });
+        }
+        for(auto& t : threads) t.join();
+        router.stop();
+        const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+        cout << producers << " producer(s), " << shards << " shard(s): "
+             << producers * events_each / elapsed.count() / 1e6 << "M events/sec, "
+             << router.transition_count(State::OffHook, State::Connecting) << " calls dialed" << endl;
+    }
+
+    // A queue capacity that isn't a power of two is rounded up, so every machine still sees
+    // its events once each and in order, and ends where one runner on its own would
+    {
+        Router router{ phone_table, machines, State::OffHook, 1, 2, 6 };
+        State_Table::MachineRunner<PhoneTable> expected{ phone_table, machines, State::OffHook };
+        for(size_t i = 0; i < 100000; ++i)
+        {
+            router.post(0, load[0][i]);
+            const State_Table::MachineRunner<PhoneTable>::Event e{ load[0][i].machine, load[0][i].trigger };
+            expected.apply(&e, 1);
+        }
+        router.stop();
+
+        bool same = true;
+        for(uint32_t m = 0; m < machines; ++m)
+            same &= router.state(m) == expected.state(m);
+        cout << (same ? "capacity 6 queues keep every event" : "capacity 6 queues lost events!") << endl;
+    }
+
+    getchar();
+    return EXIT_SUCCESS;
+}
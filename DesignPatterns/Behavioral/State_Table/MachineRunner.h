@@ -0,0 +1,144 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace State_Table
+{
+    // Drives many copies of the same state machine, such as every phone line in an exchange.
+    // Rather than an object per machine, the states of all of them are packed into one array
+    // of bytes, which is all that changes when an event arrives.
+    template <typename Table>
+    class MachineRunner
+    {
+        using State = typename Table::state_type;
+        using Trigger = typename Table::trigger_type;
+        static constexpr std::size_t states = Table::states;
+
+        const Table& table;
+        std::vector<std::uint8_t> current;
+        std::uint64_t transitions[states][states] = {}; // [from][to], only where a rule was followed
+
+        // Where every state goes on one trigger, and whether that is a rule or just staying put
+        struct Column
+        {
+            std::uint8_t next[states];
+            bool allowed[states];
+
+            Column(const Table& table, Trigger trigger)
+            {
+                for(std::size_t s = 0; s < states; ++s)
+                {
+                    next[s] = table.fire(static_cast<std::uint8_t>(s), static_cast<std::uint8_t>(trigger));
+                    allowed[s] = table.can_fire(static_cast<State>(s), trigger);
+                }
+            }
+        };
+
+        void add_transitions(const Column& column, const std::uint64_t (&from)[states])
+        {
+            for(std::size_t s = 0; s < states; ++s)
+                if(column.allowed[s])
+                    transitions[s][column.next[s]] += from[s];
+        }
+
+    public:
+        struct Event
+        {
+            std::uint32_t instance;
+            Trigger trigger;
+        };
+
+        MachineRunner(const Table& table, std::size_t machines, State initial)
+            : table{table},
+              current(machines, static_cast<std::uint8_t>(initial))
+        {
+        }
+
+        std::size_t size() const
+        {
+            return current.size();
+        }
+
+        State state(std::size_t instance) const
+        {
+            return static_cast<State>(current[instance]);
+        }
+
+        // How many times a machine went from one state to another
+        std::uint64_t transition_count(State from, State to) const
+        {
+            return transitions[static_cast<std::size_t>(from)][static_cast<std::size_t>(to)];
+        }
+
+        // Events in any order, applied one after the other
+        void apply(const Event* events, std::size_t count)
+        {
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                auto& s = current[events[i].instance];
+                const auto from = static_cast<State>(s);
+                if(table.can_fire(from, events[i].trigger))
+                {
+                    const auto to = table.fire(s, static_cast<std::uint8_t>(events[i].trigger));
+                    ++transitions[s][to];
+                    s = to;
+                }
+            }
+        }
+
+        void apply(const std::vector<Event>& events)
+        {
+            apply(events.data(), events.size());
+        }
+
+        // A group of machines all receiving the same trigger. The trigger's column of the
+        // table is looked up once, each machine is then a lookup in a few bytes.
+        // A machine listed twice receives the trigger twice.
+        void apply(Trigger trigger, const std::uint32_t* instances, std::size_t count)
+        {
+            const Column column{ table, trigger };
+            std::uint64_t from[states] = {};
+            std::uint8_t* const s = current.data();
+
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                auto& state = s[instances[i]];
+                ++from[state];
+                state = column.next[state];
+            }
+            add_transitions(column, from);
+        }
+
+        // Every machine receives the same trigger. Written as a compare and select per state,
+        // rather than a lookup, so the compiler can work on many machines per instruction
+        void apply_all(Trigger trigger)
+        {
+            const Column column{ table, trigger };
+            std::uint64_t from[states] = {};
+            std::uint8_t* const s = current.data();
+            const std::size_t n = current.size();
+
+            // Split into blocks so the counts fit in bytes, the compiler can then vectorize the counting too
+            for(std::size_t block = 0; block < n; block += 255)
+            {
+                const std::size_t end = block + 255 < n ? block + 255 : n;
+                std::uint8_t matches[states] = {};
+                for(std::size_t i = block; i < end; ++i)
+                {
+                    const std::uint8_t in = s[i];
+                    std::uint8_t out = in;
+                    for(std::size_t state = 0; state < states; ++state)
+                    {
+                        matches[state] += in == state;
+                        out = in == state ? column.next[state] : out;
+                    }
+                    s[i] = out;
+                }
+                for(std::size_t state = 0; state < states; ++state)
+                    from[state] += matches[state];
+            }
+            add_transitions(column, from);
+        }
+    };
+}
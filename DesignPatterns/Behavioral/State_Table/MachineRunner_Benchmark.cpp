@@ -0,0 +1,92 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+using namespace std;
+#include "Phone.h"
+#include "MachineRunner.h"
+
+namespace MachineRunner_Benchmark
+{
+    using Runner = State_Table::MachineRunner<State_Pattern::PhoneTable>;
+
+    template <typename Work>
+    void timed(const string& name, size_t events, Work work)
+    {
+        const auto start = chrono::steady_clock::now();
+        work();
+        const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        cout << name << ": " << events / elapsed.count() / 1e6 << "M events/sec" << endl;
+    }
+
+    void report(const Runner& runner)
+    {
+        using State_Pattern::State;
+        const State all[]{ State::OffHook, State::Connecting, State::Connected, State::OnHold };
+        for(auto from : all)
+            for(auto to : all)
+                if(runner.transition_count(from, to))
+                    cout << "  " << from << " -> " << to << ": " << runner.transition_count(from, to) << endl;
+    }
+}
+
+using namespace State_Pattern;
+using namespace MachineRunner_Benchmark;
+
+int MachineRunner_Benchmark_main(int argc, char* argv[])
+{
+    const size_t lines = 4000000; // phone lines
+    const size_t rounds = 8;
+    const Trigger day[]{ Trigger::CallDialed, Trigger::CallConnected, Trigger::PlacedOnHold,
+                         Trigger::TakenOffHold, Trigger::LeftMessage, Trigger::HungUp };
+
+    mt19937 rng{ 42 };
+    uniform_int_distribution<uint32_t> line{ 0, static_cast<uint32_t>(lines - 1) };
+    uniform_int_distribution<int> trigger{ 0, static_cast<int>(trigger_count) - 1 };
+
+    // Events for random lines, in no particular order
+    {
+        vector<Runner::Event> events(lines);
+        for(auto& e : events)
+            e = { line(rng), static_cast<Trigger>(trigger(rng)) };
+
+        Runner runner{ phone_table, lines, State::OffHook };
+        timed("one at a time", events.size() * rounds, [&]
+        {
+            for(size_t r = 0; r < rounds; ++r)
+                runner.apply(events);
+        });
+        report(runner);
+    }
+
+    // The same number of events, arriving grouped by trigger
+    {
+        vector<uint32_t> instances(lines / trigger_count);
+        for(auto& i : instances)
+            i = line(rng);
+
+        Runner runner{ phone_table, lines, State::OffHook };
+        timed("grouped by trigger", instances.size() * trigger_count * rounds, [&]
+        {
+            for(size_t r = 0; r < rounds; ++r)
+                for(auto t : day)
+                    runner.apply(t, instances.data(), instances.size());
+        });
+        report(runner);
+    }
+
+    // Every line gets every trigger in turn
+    {
+        Runner runner{ phone_table, lines, State::OffHook };
+        timed("every line", lines * trigger_count * rounds, [&]
+        {
+            for(size_t r = 0; r < rounds; ++r)
+                for(auto t : day)
+                    runner.apply_all(t);
+        });
+        report(runner);
+    }
+
+    getchar();
+    return EXIT_SUCCESS;
+}
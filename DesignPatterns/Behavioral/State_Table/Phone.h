@@ -0,0 +1,102 @@
+#pragma once
+#include <iostream>
+#include "TransitionTable.h"
+
+namespace State_Pattern
+{
+    // Lets use the phone example, we need to know the current state of the phone
+    enum class State
+    {
+        OffHook,
+        Connecting,
+        Connected,
+        OnHold
+    };
+
+    // So we can output to the console
+    inline std::ostream& operator<<(std::ostream& os, const State& s)
+    {
+        switch(s)
+        {
+            case State::OffHook:
+                os << "off the hook";
+                break;
+            case State::Connecting:
+                os << "connecting";
+                break;
+            case State::Connected:
+                os << "connected";
+                break;
+            case State::OnHold:
+                os << "on hold";
+                break;
+            default: break;
+        }
+        return os;
+    }
+
+    // Now we need something that will cause the state to change
+    enum class Trigger
+    {
+        CallDialed,
+        HungUp,
+        CallConnected,
+        PlacedOnHold,
+        TakenOffHold,
+        LeftMessage
+    };
+
+    // again so we can output to the console
+    inline std::ostream& operator<<(std::ostream& os, const Trigger& t)
+    {
+        switch(t)
+        {
+            case Trigger::CallDialed:
+                os << "call dialed";
+                break;
+            case Trigger::HungUp:
+                os << "hung up";
+                break;
+            case Trigger::CallConnected:
+                os << "call connected";
+                break;
+            case Trigger::PlacedOnHold:
+                os << "placed on hold";
+                break;
+            case Trigger::TakenOffHold:
+                os << "taken off hold";
+                break;
+            case Trigger::LeftMessage:
+                os << "left message";
+                break;
+            default: break;
+        }
+        return os;
+    }
+
+    constexpr std::size_t state_count = 4;
+    constexpr std::size_t trigger_count = 6;
+
+    using PhoneTable = State_Table::TransitionTable<State, Trigger, state_count, trigger_count>;
+
+    // Every state, along with what triggers are available and which state that trigger will lead to
+    constexpr PhoneTable::Rule phone_rules[]{
+        // The phone is off the hook. So we can dial, which will lead to connecting
+        { State::OffHook, Trigger::CallDialed, State::Connecting },
+
+        // While the phone is connecting, we can either hang up to return to the
+        // OffHook state or, the call can be connected, which leads to the connected state
+        { State::Connecting, Trigger::HungUp, State::OffHook },
+        { State::Connecting, Trigger::CallConnected, State::Connected },
+
+        { State::Connected, Trigger::LeftMessage, State::OffHook },
+        { State::Connected, Trigger::HungUp, State::OffHook },
+        { State::Connected, Trigger::PlacedOnHold, State::OnHold },
+
+        { State::OnHold, Trigger::TakenOffHold, State::Connected },
+        { State::OnHold, Trigger::HungUp, State::OffHook }
+    };
+
+    // Built by the compiler, there is nothing left to do at runtime
+    constexpr PhoneTable phone_table{ phone_rules };
+}
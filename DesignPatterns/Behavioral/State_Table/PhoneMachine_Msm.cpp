@@ -0,0 +1,42 @@
+#define _SCL_SECURE_NO_WARNINGS // boost compile errors
+#include "PhoneMachines.h"
+#include "../State_boost.h"
+
+namespace PhoneMachines
+{
+    using Phone = msm::back::state_machine<State_boost::PhoneStateMachine>;
+
+    // MSM has a type per event, so each is turned into its event
+    void process(Phone& phone, PhoneEvent e)
+    {
+        switch(e)
+        {
+            case PhoneEvent::CallDialed: phone.process_event(State_boost::CallDialed{}); break;
+            case PhoneEvent::HungUp: phone.process_event(State_boost::HungUp{}); break;
+            case PhoneEvent::CallConnected: phone.process_event(State_boost::CallConnected{}); break;
+            case PhoneEvent::PlacedOnHold: phone.process_event(State_boost::PlacedOnHold{}); break;
+            case PhoneEvent::TakenOffHold: phone.process_event(State_boost::TakenOffHold{}); break;
+            case PhoneEvent::LeftMessage: phone.process_event(State_boost::LeftMessage{}); break;
+            case PhoneEvent::PhoneThrownIntoWall: phone.process_event(State_boost::PhoneThrownIntoWall{}); break;
+            default: break;
+        }
+    }
+
+    std::vector<PhoneState> run_msm(const std::vector<Event>& events, const std::vector<bool>& angry)
+    {
+        std::vector<Phone> phones(angry.size());
+        for(std::size_t i = 0; i < phones.size(); ++i)
+        {
+            phones[i].quiet = true;
+            phones[i].angry = angry[i];
+        }
+
+        for(auto& e : events)
+            process(phones[e.phone], e.event);
+
+        std::vector<PhoneState> states;
+        for(auto& phone : phones)
+            states.push_back(static_cast<PhoneState>(phone.current_state()[0]));
+        return states;
+    }
+}
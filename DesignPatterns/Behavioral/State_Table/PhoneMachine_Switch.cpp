@@ -0,0 +1,58 @@
+#include <iostream>
+#include "PhoneMachines.h"
+
+namespace PhoneMachines
+{
+    // The same machine written out by hand, the compiler turns the switches into jump tables
+    struct SwitchPhone
+    {
+        PhoneState state = PhoneState::OffHook;
+        bool angry = false;
+        bool quiet = true;
+
+        void process(PhoneEvent e)
+        {
+            switch(state)
+            {
+                case PhoneState::OffHook:
+                    if(e == PhoneEvent::CallDialed)
+                    {
+                        state = PhoneState::Connecting;
+                        if(!quiet) std::cout << "We are connecting..." << std::endl; // Connecting's on_entry
+                    }
+                    break;
+                case PhoneState::Connecting:
+                    if(e == PhoneEvent::CallConnected)
+                        state = PhoneState::Connected;
+                    break;
+                case PhoneState::Connected:
+                    if(e == PhoneEvent::PlacedOnHold)
+                        state = PhoneState::OnHold;
+                    break;
+                case PhoneState::OnHold:
+                    if(e == PhoneEvent::PhoneThrownIntoWall && angry) // CanDestoryPhone
+                    {
+                        if(!quiet) std::cout << "Phone breaks into a million pieces" << std::endl; // PhoneBeingDestoryed
+                        state = PhoneState::Destroyed;
+                    }
+                    break;
+                default: break;
+            }
+        }
+    };
+
+    std::vector<PhoneState> run_switch(const std::vector<Event>& events, const std::vector<bool>& angry)
+    {
+        std::vector<SwitchPhone> phones(angry.size());
+        for(std::size_t i = 0; i < phones.size(); ++i)
+            phones[i].angry = angry[i];
+
+        for(auto& e : events)
+            phones[e.phone].process(e.event);
+
+        std::vector<PhoneState> states;
+        for(auto& phone : phones)
+            states.push_back(phone.state);
+        return states;
+    }
+}
@@ -0,0 +1,94 @@
+#include <iostream>
+#include "PhoneMachines.h"
+#include "TransitionTable.h"
+
+namespace PhoneMachines
+{
+    using Table = State_Table::TransitionTable<PhoneState, PhoneEvent, state_count, event_count>;
+
+    constexpr Table::Rule rules[]{
+        { PhoneState::OffHook, PhoneEvent::CallDialed, PhoneState::Connecting },
+        { PhoneState::Connecting, PhoneEvent::CallConnected, PhoneState::Connected },
+        { PhoneState::Connected, PhoneEvent::PlacedOnHold, PhoneState::OnHold },
+        { PhoneState::OnHold, PhoneEvent::PhoneThrownIntoWall, PhoneState::Destroyed }
+    };
+    constexpr Table table{ rules };
+
+    struct TablePhone;
+
+    // The table only knows where a trigger leads, guards and actions sit in a table of
+    // their own, empty for most transitions, so only those that have them pay for them
+    struct Behaviour
+    {
+        bool (*guard)(const TablePhone&);
+        void (*action)(const TablePhone&);
+    };
+
+    struct TablePhone
+    {
+        PhoneState state = PhoneState::OffHook;
+        bool angry = false;
+        bool quiet = true;
+
+        void process(PhoneEvent e);
+    };
+
+    bool can_destroy_phone(const TablePhone& phone)
+    {
+        return phone.angry;
+    }
+
+    void phone_being_destroyed(const TablePhone& phone)
+    {
+        if(!phone.quiet) std::cout << "Phone breaks into a million pieces" << std::endl;
+    }
+
+    void connecting_entry(const TablePhone& phone)
+    {
+        if(!phone.quiet) std::cout << "We are connecting..." << std::endl;
+    }
+
+    struct Behaviours
+    {
+        Behaviour transitions[state_count][event_count] = {};
+        void (*on_entry[state_count])(const TablePhone&) = {};
+
+        Behaviours()
+        {
+            transitions[static_cast<std::size_t>(PhoneState::OnHold)][static_cast<std::size_t>(PhoneEvent::PhoneThrownIntoWall)] =
+                { can_destroy_phone, phone_being_destroyed };
+            on_entry[static_cast<std::size_t>(PhoneState::Connecting)] = connecting_entry;
+        }
+    };
+    const Behaviours behaviours;
+
+    void TablePhone::process(PhoneEvent e)
+    {
+        const auto from = state;
+        const auto& b = behaviours.transitions[static_cast<std::size_t>(from)][static_cast<std::size_t>(e)];
+        if(b.guard && !b.guard(*this))
+            return;
+        if(b.action)
+            b.action(*this);
+
+        state = table.fire(from, e);
+        if(state != from)
+            if(const auto entry = behaviours.on_entry[static_cast<std::size_t>(state)])
+                entry(*this);
+    }
+
+    std::vector<PhoneState> run_table(const std::vector<Event>& events, const std::vector<bool>& angry)
+    {
+        std::vector<TablePhone> phones(angry.size());
+        for(std::size_t i = 0; i < phones.size(); ++i)
+            phones[i].angry = angry[i];
+
+        for(auto& e : events)
+            phones[e.phone].process(e.event);
+
+        std::vector<PhoneState> states;
+        for(auto& phone : phones)
+            states.push_back(phone.state);
+        return states;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace PhoneMachines
+{
+    // The phone from State_boost.h, with the same rules, guard and action,
+    // built three ways so we can compare them:
+    // - Boost.MSM, its transition table is an mpl::vector worked out by the compiler
+    // - a switch on the state, then on the event
+    // - a dense [state][event] table, with the guard and action in a table beside it
+    // Each lives in its own .cpp, so their build times can be compared too
+
+    // In the order MSM numbers them, the order they first appear in its transition table
+    enum class PhoneState : std::uint8_t
+    {
+        OffHook,
+        Connecting,
+        Connected,
+        OnHold,
+        Destroyed
+    };
+
+    enum class PhoneEvent : std::uint8_t
+    {
+        CallDialed,
+        HungUp,
+        CallConnected,
+        PlacedOnHold,
+        TakenOffHold,
+        LeftMessage,
+        PhoneThrownIntoWall
+    };
+
+    constexpr std::size_t state_count = 5;
+    constexpr std::size_t event_count = 7;
+
+    struct Event
+    {
+        std::uint32_t phone;
+        PhoneEvent event;
+    };
+
+    // Every phone starts off the hook, those with angry set may destroy their phone.
+    // Returns the final state of every phone, so the three can be checked against each other
+    std::vector<PhoneState> run_msm(const std::vector<Event>& events, const std::vector<bool>& angry);
+    std::vector<PhoneState> run_switch(const std::vector<Event>& events, const std::vector<bool>& angry);
+    std::vector<PhoneState> run_table(const std::vector<Event>& events, const std::vector<bool>& angry);
+}
@@ -0,0 +1,62 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+using namespace std;
+#include "PhoneMachines.h"
+
+// Runtime is measured here. For build time, each machine is in its own .cpp:
+// the project compiles PhoneMachine_Msm.cpp, PhoneMachine_Switch.cpp and PhoneMachine_Table.cpp
+// with /Bt+, so the build output lists the front end and back end time of each
+// (with gcc or clang, compile each with -ftime-report).
+
+using namespace PhoneMachines;
+
+int PhoneMachines_Benchmark_main(int argc, char* argv[])
+{
+    const size_t phones = 4096;
+    const size_t event_count = 20000000;
+
+    // One phone in 16 is angry, so the guard usually says no and the action runs now and then
+    vector<bool> angry(phones);
+    for(size_t i = 0; i < phones; ++i)
+        angry[i] = i % 16 == 0;
+
+    // Mostly dialing, connecting and holding, so phones keep moving through the table
+    mt19937 rng{ 42 };
+    uniform_int_distribution<uint32_t> phone{ 0, static_cast<uint32_t>(phones - 1) };
+    discrete_distribution<int> event{ 4, 1, 4, 4, 1, 1, 1 };
+    vector<Event> events(event_count);
+    for(auto& e : events)
+        e = { phone(rng), static_cast<PhoneEvent>(event(rng)) };
+
+    using Run = vector<PhoneState>(*)(const vector<Event>&, const vector<bool>&);
+    const pair<string, Run> machines[]{
+        { "msm", run_msm },
+        { "switch", run_switch },
+        { "table", run_table }
+    };
+
+    vector<PhoneState> expected;
+    for(auto& machine : machines)
+    {
+        const auto start = chrono::steady_clock::now();
+        const auto states = machine.second(events, angry);
+        const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+        size_t destroyed = 0;
+        for(auto s : states)
+            destroyed += s == PhoneState::Destroyed;
+
+        if(expected.empty())
+            expected = states;
+
+        cout << machine.first << ": " << elapsed.count() * 1e9 / event_count << "ns/event, "
+             << destroyed << " phones destroyed"
+             << (states == expected ? "" : " (DIFFERS FROM MSM)") << endl;
+    }
+
+    getchar();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "../State_boost.h"
+
+namespace State_Table
+{
+    // The phone from Phone.h as a Boost.MSM machine. State_boost.h only has a few of
+    // the rules, so it would do less work than phone_table and the two can't be compared.
+    // Here every one of phone_rules is a row, in the same order, so MSM numbers the
+    // states the same way State_Pattern::State does
+    struct PhoneMsm : msm::front::state_machine_def<PhoneMsm>
+    {
+        struct OffHook : msm::front::state<> {};
+        struct Connecting : msm::front::state<> {};
+        struct Connected : msm::front::state<> {};
+        struct OnHold : msm::front::state<> {};
+
+        struct transition_table : mpl::vector<
+            msm::front::Row<OffHook, State_boost::CallDialed, Connecting>,
+            msm::front::Row<Connecting, State_boost::HungUp, OffHook>,
+            msm::front::Row<Connecting, State_boost::CallConnected, Connected>,
+            msm::front::Row<Connected, State_boost::LeftMessage, OffHook>,
+            msm::front::Row<Connected, State_boost::HungUp, OffHook>,
+            msm::front::Row<Connected, State_boost::PlacedOnHold, OnHold>,
+            msm::front::Row<OnHold, State_boost::TakenOffHold, Connected>,
+            msm::front::Row<OnHold, State_boost::HungUp, OffHook>
+        >{};
+
+        typedef OffHook initial_state;
+
+        // Like phone_table, a trigger with no rule leaves the phone where it is
+        template <class FSM, class Event>
+        void no_transition(Event const&, FSM&, int)
+        {
+        }
+    };
+}
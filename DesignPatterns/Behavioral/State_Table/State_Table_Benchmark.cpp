@@ -0,0 +1,73 @@
+#include <iostream>
+#include <vector>
+#include <map>
+#include <random>
+#include <chrono>
+using namespace std;
+#include "Phone.h"
+
+namespace State_Table_Benchmark
+{
+    // The same phone rules, as a map of states to a list of triggers and where they lead.
+    // Every transition is a tree lookup followed by a linear scan
+    map<State_Pattern::State, vector<pair<State_Pattern::Trigger, State_Pattern::State>>> map_rules()
+    {
+        map<State_Pattern::State, vector<pair<State_Pattern::Trigger, State_Pattern::State>>> rules;
+        for(auto& rule : State_Pattern::phone_rules)
+            rules[rule.from].emplace_back(rule.trigger, rule.to);
+        return rules;
+    }
+
+    // Random triggers, many won't have a rule for the current state which leaves the state alone
+    vector<State_Pattern::Trigger> synthetic_events(size_t count)
+    {
+        mt19937 rng{ 42 };
+        uniform_int_distribution<int> trigger{ 0, static_cast<int>(State_Pattern::trigger_count) - 1 };
+        vector<State_Pattern::Trigger> events(count);
+        for(auto& e : events)
+            e = static_cast<State_Pattern::Trigger>(trigger(rng));
+        return events;
+    }
+
+    template <typename Step>
+    void run(const string& name, const vector<State_Pattern::Trigger>& events, size_t repeats, Step step)
+    {
+        auto state = State_Pattern::State::OffHook;
+        const auto start = chrono::steady_clock::now();
+        for(size_t r = 0; r < repeats; ++r)
+            for(auto e : events)
+                state = step(state, e);
+        const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+        const auto total = events.size() * repeats;
+        cout << name << ": " << total << " events in " << elapsed.count() << "s, "
+             << elapsed.count() * 1e9 / total << "ns/event (ended " << state << ")" << endl;
+    }
+}
+
+using namespace State_Pattern;
+using namespace State_Table_Benchmark;
+
+int State_Table_Benchmark_main(int argc, char* argv[])
+{
+    // 200 million events, replaying a buffer that fits in cache so we measure the lookup
+    const auto events = synthetic_events(1 << 20);
+    const size_t repeats = 200;
+
+    auto rules = map_rules();
+    run("map", events, repeats, [&](State s, Trigger t)
+    {
+        for(auto& rule : rules[s])
+            if(rule.first == t)
+                return rule.second;
+        return s;
+    });
+
+    run("table", events, repeats, [](State s, Trigger t)
+    {
+        return phone_table.fire(s, t);
+    });
+
+    getchar();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,200 @@
+#define _SCL_SECURE_NO_WARNINGS // boost compile errors
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+using namespace std;
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include "Phone.h"
+#include "MachineRunner.h"
+#include "PhoneMsm.h"
+
+namespace Trace_Replay
+{
+    // Rather than typing triggers in, we replay a recording of them.
+    // A trace is a file of fixed size records, one per event
+    struct TraceRecord
+    {
+        uint32_t machine;
+        uint8_t trigger; // a State_Pattern::Trigger
+        uint8_t unused[3];
+    };
+    static_assert(sizeof(TraceRecord) == 8, "trace records are written to disk as is");
+
+    // So we have something to replay
+    void write_trace(const string& path, uint32_t machines, size_t events)
+    {
+        mt19937 rng{ 42 };
+        uniform_int_distribution<uint32_t> machine{ 0, machines - 1 };
+        uniform_int_distribution<int> trigger{ 0, static_cast<int>(State_Pattern::trigger_count) - 1 };
+
+        ofstream ofs{ path, ios::binary };
+        for(size_t i = 0; i < events; ++i)
+        {
+            TraceRecord r{ machine(rng), static_cast<uint8_t>(trigger(rng)), {} };
+            ofs.write(reinterpret_cast<const char*>(&r), sizeof r);
+        }
+    }
+
+    // Latencies counted in power of two buckets of nanoseconds
+    struct Histogram
+    {
+        static constexpr size_t buckets = 24; // up to about 8ms, anything slower goes in the last bucket
+        uint64_t counts[buckets] = {};
+
+        void add(chrono::nanoseconds latency)
+        {
+            size_t bucket = 0;
+            for(auto ns = latency.count(); ns > 1 && bucket + 1 < buckets; ns >>= 1)
+                ++bucket;
+            ++counts[bucket];
+        }
+
+        void print() const
+        {
+            for(size_t b = 0; b < buckets; ++b)
+                if(counts[b])
+                    cout << "  < " << (2ull << b) << "ns: " << counts[b] << endl;
+        }
+    };
+
+    // Plays the whole trace through step(machine, trigger) twice. First flat out to
+    // measure throughput, then timing every event to build the latency histogram
+    template <typename Step>
+    void replay(const string& engine, const TraceRecord* records, size_t count, Step step)
+    {
+        const auto start = chrono::steady_clock::now();
+        for(size_t i = 0; i < count; ++i)
+            step(records[i].machine, static_cast<State_Pattern::Trigger>(records[i].trigger));
+        const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        cout << engine << ": " << count / elapsed.count() / 1e6 << "M events/sec" << endl;
+
+        Histogram histogram;
+        for(size_t i = 0; i < count; ++i)
+        {
+            const auto before = chrono::steady_clock::now();
+            step(records[i].machine, static_cast<State_Pattern::Trigger>(records[i].trigger));
+            histogram.add(chrono::steady_clock::now() - before);
+        }
+        cout << engine << " latency (includes the cost of reading the clock):" << endl;
+        histogram.print();
+    }
+
+    // MSM has a type per event, so each trigger is turned into its event
+    template <typename Phone>
+    void process(Phone& phone, State_Pattern::Trigger trigger)
+    {
+        using State_Pattern::Trigger;
+        switch(trigger)
+        {
+            case Trigger::CallDialed: phone.process_event(State_boost::CallDialed{}); break;
+            case Trigger::HungUp: phone.process_event(State_boost::HungUp{}); break;
+            case Trigger::CallConnected: phone.process_event(State_boost::CallConnected{}); break;
+            case Trigger::PlacedOnHold: phone.process_event(State_boost::PlacedOnHold{}); break;
+            case Trigger::TakenOffHold: phone.process_event(State_boost::TakenOffHold{}); break;
+            case Trigger::LeftMessage: phone.process_event(State_boost::LeftMessage{}); break;
+            default: break;
+        }
+    }
+}
+
+using namespace State_Pattern;
+using namespace Trace_Replay;
+namespace bip = boost::interprocess;
+
+// Trace_Replay [trace file] [table|msm|both]
+// Without a trace file one is made up, with 10 million events over 100,000 phones
+int Trace_Replay_main(int argc, char* argv[])
+{
+    const string path = argc > 1 ? argv[1] : "phone_trace.bin";
+    const string engine = argc > 2 ? argv[2] : "both";
+    if(engine != "table" && engine != "msm" && engine != "both")
+    {
+        cout << "Unknown engine " << engine << ", use table, msm or both" << endl;
+        getchar();
+        return EXIT_FAILURE;
+    }
+
+    if(argc <= 1 && !ifstream{ path })
+    {
+        cout << "Writing " << path << endl;
+        write_trace(path, 100000, 10000000);
+    }
+
+    // A trace is whole records and nothing else, anything else isn't one of ours
+    const auto size = ifstream{ path, ios::binary | ios::ate }.tellg();
+    if(size <= 0 || size % sizeof(TraceRecord) != 0)
+    {
+        cout << path << " is not a trace, it must be a whole number of " << sizeof(TraceRecord) << " byte records" << endl;
+        getchar();
+        return EXIT_FAILURE;
+    }
+
+    // Map the file rather than reading it, the OS pages it in as we go
+    bip::file_mapping file{ path.c_str(), bip::read_only };
+    bip::mapped_region region{ file, bip::read_only };
+    const auto records = static_cast<const TraceRecord*>(region.get_address());
+    const auto count = region.get_size() / sizeof(TraceRecord);
+
+    uint64_t machines = 0;
+    for(size_t i = 0; i < count; ++i)
+    {
+        // The tables are indexed by the trigger, so a bad byte would read past the end
+        if(records[i].trigger >= trigger_count)
+        {
+            cout << "record " << i << " has trigger " << +records[i].trigger
+                 << ", there are only " << trigger_count << endl;
+            getchar();
+            return EXIT_FAILURE;
+        }
+        // Every phone is made up front, one per number up to the biggest. Numbered from 0 with
+        // at least one event each, there can't be more phones than events, so a number
+        // that big is a bad record, and would have us make far too many
+        if(records[i].machine >= count)
+        {
+            cout << "record " << i << " is for phone " << records[i].machine
+                 << ", a trace of " << count << " events can't have a phone numbered that high" << endl;
+            getchar();
+            return EXIT_FAILURE;
+        }
+        machines = max<uint64_t>(machines, uint64_t{ records[i].machine } + 1);
+    }
+    cout << count << " events for " << machines << " phones" << endl;
+
+    State_Table::MachineRunner<PhoneTable> runner{ phone_table, static_cast<size_t>(machines), State::OffHook };
+    if(engine == "table" || engine == "both")
+    {
+        replay("table", records, count, [&](uint32_t machine, Trigger trigger)
+        {
+            const State_Table::MachineRunner<PhoneTable>::Event e{ machine, trigger };
+            runner.apply(&e, 1);
+        });
+    }
+
+    if(engine == "msm" || engine == "both")
+    {
+        vector<msm::back::state_machine<State_Table::PhoneMsm>> phones(static_cast<size_t>(machines));
+        replay("msm", records, count, [&](uint32_t machine, Trigger trigger)
+        {
+            process(phones[machine], trigger);
+        });
+
+        // Both ran the same rules over the same trace, so they should end up agreeing
+        if(engine == "both")
+        {
+            size_t differ = 0;
+            for(uint32_t i = 0; i < machines; ++i)
+                if(static_cast<State>(phones[i].current_state()[0]) != runner.state(i))
+                    ++differ;
+            cout << (differ ? to_string(differ) + " phones differ" : "both agree") << endl;
+        }
+    }
+
+    getchar();
+    return EXIT_SUCCESS;
+}
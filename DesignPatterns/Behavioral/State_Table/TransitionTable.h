@@ -0,0 +1,78 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace State_Table
+{
+    // A state machine's rules as a dense [state][trigger] table, built at compile time.
+    // Looking up a transition is then a single indexed load, rather than searching a map
+    // of states and then a list of triggers.
+    // States and triggers must be enums numbered from 0, StateCount and TriggerCount say how many.
+    template <typename TState, typename TTrigger, std::size_t StateCount, std::size_t TriggerCount>
+    class TransitionTable
+    {
+        static_assert(StateCount <= 256, "states are stored as uint8_t");
+
+        // A trigger with no rule leaves the state as it is, so a missing rule needs no branch
+        std::uint8_t next[StateCount][TriggerCount];
+        bool allowed[StateCount][TriggerCount];
+    public:
+        using state_type = TState;
+        using trigger_type = TTrigger;
+        static constexpr std::size_t states = StateCount;
+        static constexpr std::size_t triggers = TriggerCount;
+
+        struct Rule
+        {
+            TState from;
+            TTrigger trigger;
+            TState to;
+        };
+
+        template <std::size_t N>
+        constexpr explicit TransitionTable(const Rule (&rules)[N])
+            : next{},
+              allowed{}
+        {
+            for(std::size_t s = 0; s < StateCount; ++s)
+                for(std::size_t t = 0; t < TriggerCount; ++t)
+                    next[s][t] = static_cast<std::uint8_t>(s);
+
+            for(std::size_t i = 0; i < N; ++i)
+            {
+                const auto s = static_cast<std::size_t>(rules[i].from);
+                const auto t = static_cast<std::size_t>(rules[i].trigger);
+                next[s][t] = static_cast<std::uint8_t>(rules[i].to);
+                allowed[s][t] = true;
+            }
+        }
+
+        constexpr bool can_fire(TState state, TTrigger trigger) const
+        {
+            return allowed[static_cast<std::size_t>(state)][static_cast<std::size_t>(trigger)];
+        }
+
+        // The state after the trigger, or the same state if there's no rule for it
+        constexpr TState fire(TState state, TTrigger trigger) const
+        {
+            return static_cast<TState>(next[static_cast<std::size_t>(state)][static_cast<std::size_t>(trigger)]);
+        }
+
+        // The same on raw state numbers, for when states are kept packed
+        constexpr std::uint8_t fire(std::uint8_t state, std::uint8_t trigger) const
+        {
+            return next[state][trigger];
+        }
+
+        // The triggers that have a rule from this state, in the order the trigger enum lists them
+        std::vector<TTrigger> available(TState state) const
+        {
+            std::vector<TTrigger> result;
+            for(std::size_t t = 0; t < TriggerCount; ++t)
+                if(allowed[static_cast<std::size_t>(state)][t])
+                    result.push_back(static_cast<TTrigger>(t));
+            return result;
+        }
+    };
+}
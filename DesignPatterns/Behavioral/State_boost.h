@@ -0,0 +1,106 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <typeinfo>
+
+//back-end
+#include <boost/msm/back/state_machine.hpp>
+
+// front-end
+#include <boost/msm/front/state_machine_def.hpp>
+#include <boost/msm/front/functor_row.hpp>
+
+// MSM = Meta state machine
+namespace msm = boost::msm;
+// MPL = Meta programming library
+namespace mpl = boost::mpl;
+
+
+namespace State_boost
+{
+    // So we can output the state later
+    const std::vector<std::string> state_names {
+        "off hook",
+        "connecting",
+        "connected",
+        "on hold",
+        "destroyed"
+    };
+
+    // Each of our triggers
+    struct CallDialed {};
+    struct HungUp {};
+    struct CallConnected {};
+    struct PlacedOnHold {};
+    struct TakenOffHold {};
+    struct LeftMessage {};
+    struct PhoneThrownIntoWall {};
+
+    // Our state machine needs to inherit from boost::msm
+    struct PhoneStateMachine : msm::front::state_machine_def<PhoneStateMachine>
+    {
+        // Each of our states are created as structs within the state machine
+        // Notice that they all need to inherit from boost::msm
+        struct OffHook : msm::front::state<> {};
+        // We can invoke additional events, such as when the state is set
+        struct Connecting : msm::front::state<>
+        {
+            template <class Event, class FSM>
+            void on_entry(Event const& evt, FSM& fsm)
+            {
+                if(!fsm.quiet)
+                    std::cout << "We are connecting..." << std::endl;
+            } // we can also do on_exit for example
+        };
+
+        // This is not a state, but an action that can be invoked during a state transition
+        struct PhoneBeingDestoryed
+        {
+            template <class EVT, class FSM, class SourceState, class TargetState>
+            void operator()(EVT const&, FSM& fsm, SourceState&, TargetState&)
+            {
+                if(!fsm.quiet)
+                    std::cout << "Phone breaks into a million pieces" << std::endl;
+            }
+        };
+
+        // We can also setup a guard to decide if the above action will be invoked
+        bool angry { false };
+        bool quiet { false }; // no console output, for when we drive lots of phones
+        struct CanDestoryPhone
+        {
+            template <class EVT, class FSM, class SourceState, class TargetState>
+            bool operator()(EVT const&, FSM& fsm, SourceState&, TargetState&)
+            {
+                return fsm.angry;
+            }
+        };
+
+        struct Connected : msm::front::state<> {};
+        struct OnHold : msm::front::state<> {};
+        struct PhoneDestroyed : msm::front::state<> {};
+
+        // required by boost msn to have a transition table
+        // Here we choose which trigger causes the state to transition to another state
+        struct transition_table : mpl::vector<
+            msm::front::Row<OffHook, CallDialed, Connecting>, // <currentState, Trigger, newState>
+            msm::front::Row<Connecting, CallConnected, Connected>,
+            msm::front::Row<Connected, PlacedOnHold, OnHold>,
+            msm::front::Row<OnHold, PhoneThrownIntoWall, PhoneDestroyed, PhoneBeingDestoryed, CanDestoryPhone> // <currentState, Trigger, newState, actionToInvoke, guard>
+        >{};
+
+        typedef OffHook initial_state;
+
+        // If we don't have a map for a state to transition on a certain trigger
+        // we can create an addition event to be called as such
+        template <class FSM, class Event>
+        void no_transition(Event const& e, FSM&, int state)
+        {
+            if(quiet) return;
+            std::cout << "No transition from state " << state_names[state]
+                 << " on event " << typeid(e).name() << std::endl;
+        }
+    };
+}
+
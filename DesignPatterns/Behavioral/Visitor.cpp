@@ -3,6 +3,12 @@
 #include <algorithm>
 #include <sstream>
 #include <vector>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
 using namespace std;
 
 namespace Visitor
@@ -152,9 +158,319 @@ namespace Visitor
                 x.accept(*this);
         }
 
+        std::string str() const override
+        {
+            return oss.str();
+        }
+
     private:
         ostringstream oss;
     };
+
+    // str() hands back the whole document at once, so all of it has to be held in memory
+    // and nothing can be sent until the last element is rendered. Instead a visitor can
+    // write to a sink as it goes, a chunk at a time.
+
+    // Where rendered output goes, a file, a socket...
+    struct Sink
+    {
+        virtual ~Sink() = default;
+        virtual void write(const char* data, size_t size) = 0;
+    };
+
+    // Any stream the caller hands us, cout, a file they opened...
+    struct StreamSink : Sink
+    {
+        explicit StreamSink(ostream& os)
+            : os{os}
+        {
+        }
+
+        void write(const char* data, size_t size) override
+        {
+            os.write(data, size);
+        }
+
+    private:
+        ostream& os;
+    };
+
+    // Collects output into a fixed size buffer, passing it on to the sink each time it fills
+    class ChunkedWriter
+    {
+        Sink& sink;
+        vector<char> buffer;
+        size_t used = 0;
+    public:
+        ChunkedWriter(Sink& sink, size_t chunk_size)
+            : sink{sink},
+              buffer(chunk_size)
+        {
+        }
+
+        ~ChunkedWriter()
+        {
+            flush();
+        }
+
+        ChunkedWriter& operator<<(const string& s)
+        {
+            return write(s.data(), s.size());
+        }
+
+        ChunkedWriter& operator<<(const char* s)
+        {
+            return write(s, strlen(s));
+        }
+
+        ChunkedWriter& write(const char* data, size_t size)
+        {
+            if(used + size > buffer.size())
+            {
+                flush();
+                if(size > buffer.size()) // too big to buffer, pass it straight on
+                {
+                    sink.write(data, size);
+                    return *this;
+                }
+            }
+            memcpy(buffer.data() + used, data, size);
+            used += size;
+            return *this;
+        }
+
+        void flush()
+        {
+            if(used)
+                sink.write(buffer.data(), used);
+            used = 0;
+        }
+    };
+
+    // Renders straight into a sink, memory use is the chunk size whatever the size of the document
+    struct StreamingVisitor : Visitor
+    {
+        explicit StreamingVisitor(Sink& sink, size_t chunk_size = 64 * 1024)
+            : out{sink, chunk_size}
+        {
+        }
+
+        // Send whatever is still buffered, also done when the visitor is destroyed
+        void flush()
+        {
+            out.flush();
+        }
+
+        std::string str() const override
+        {
+            return {}; // the output has already gone to the sink
+        }
+
+    protected:
+        ChunkedWriter out;
+    };
+
+    struct StreamingHtmlVisitor : StreamingVisitor
+    {
+        using StreamingVisitor::StreamingVisitor;
+
+        void visit(const Paragraph& p) override
+        {
+            out << "<p>" << p.text << "</p>\n";
+        }
+
+        void visit(const ListItem& p) override
+        {
+            out << "<li>" << p.text << "</li>\n";
+        }
+
+        void visit(const List& p) override
+        {
+            out << "<ul>\n";
+            for(auto& x : p)
+                x.accept(*this);
+            out << "</ul>\n";
+        }
+    };
+
+    struct StreamingMarkdownVisitor : StreamingVisitor
+    {
+        using StreamingVisitor::StreamingVisitor;
+
+        void visit(const Paragraph& p) override
+        {
+            out << p.text << "\n";
+        }
+
+        void visit(const ListItem& p) override
+        {
+            out << " * " << p.text << "\n";
+        }
+
+        void visit(const List& p) override
+        {
+            for(auto& x : p)
+                x.accept(*this);
+        }
+    };
+
+    // Top level elements don't depend on each other, so a big document can be rendered
+    // on several threads. The elements are split into chunks, each thread takes the next
+    // chunk and renders it with its own visitor, the chunks are then joined back in order.
+    template <typename TVisitor>
+    string render_parallel(const vector<Element*>& document,
+                           unsigned threads = max(1u, thread::hardware_concurrency()),
+                           size_t chunk_size = 1024)
+    {
+        const auto chunks = (document.size() + chunk_size - 1) / chunk_size;
+        vector<string> rendered(chunks);
+        atomic<size_t> next{ 0 };
+
+        const auto work = [&]
+        {
+            for(auto c = next++; c < chunks; c = next++)
+            {
+                TVisitor v;
+                const auto end = min(document.size(), (c + 1) * chunk_size);
+                for(auto i = c * chunk_size; i < end; ++i)
+                    document[i]->accept(v);
+                rendered[c] = v.str();
+            }
+        };
+
+        vector<thread> workers;
+        for(unsigned t = 1; t < threads; ++t)
+            workers.emplace_back(work);
+        work(); // this thread helps too
+        for(auto& w : workers)
+            w.join();
+
+        size_t total = 0;
+        for(auto& r : rendered)
+            total += r.size();
+        string out;
+        out.reserve(total);
+        for(auto& r : rendered)
+            out += r;
+        return out;
+    }
+
+    // Every element above is its own heap object, and rendering one costs two virtual calls,
+    // accept then visit. For large documents we can instead lay the whole document out flat:
+    // one array of small records, in the order they are rendered, with all the text in one buffer.
+    // Rendering is then a single pass over contiguous memory with a switch on each record.
+    struct FlatDocument
+    {
+        enum class Kind : uint8_t
+        {
+            Paragraph,
+            ListItem,
+            ListBegin,
+            ListEnd
+        };
+
+        struct Record
+        {
+            Kind kind;
+            uint32_t offset; // where the text starts in text
+            uint32_t length;
+        };
+
+        vector<Record> records;
+        string text;
+
+        void paragraph(const string& t) { add(Kind::Paragraph, t); }
+        void list_item(const string& t) { add(Kind::ListItem, t); }
+        void list_begin() { add(Kind::ListBegin, {}); }
+        void list_end() { add(Kind::ListEnd, {}); }
+
+        // The text belonging to a record
+        const char* data(const Record& r) const { return text.data() + r.offset; }
+
+    private:
+        void add(Kind kind, const string& t)
+        {
+            records.push_back({ kind, static_cast<uint32_t>(text.size()), static_cast<uint32_t>(t.size()) });
+            text += t;
+        }
+    };
+
+    // We can flatten an existing document with a visitor of course
+    struct FlatteningVisitor : Visitor
+    {
+        FlatDocument document;
+
+        void visit(const Paragraph& p) override
+        {
+            document.paragraph(p.text);
+        }
+
+        void visit(const ListItem& p) override
+        {
+            document.list_item(p.text);
+        }
+
+        void visit(const List& p) override
+        {
+            document.list_begin();
+            for(auto& x : p)
+                x.accept(*this);
+            document.list_end();
+        }
+
+        std::string str() const override
+        {
+            return {};
+        }
+    };
+
+    // The same output as HtmlVisitor
+    inline string render_html(const FlatDocument& d)
+    {
+        string out;
+        out.reserve(d.text.size() + d.records.size() * 12);
+        for(auto& r : d.records)
+        {
+            switch(r.kind)
+            {
+                case FlatDocument::Kind::Paragraph:
+                    out.append("<p>").append(d.data(r), r.length).append("</p>\n");
+                    break;
+                case FlatDocument::Kind::ListItem:
+                    out.append("<li>").append(d.data(r), r.length).append("</li>\n");
+                    break;
+                case FlatDocument::Kind::ListBegin:
+                    out.append("<ul>\n");
+                    break;
+                case FlatDocument::Kind::ListEnd:
+                    out.append("</ul>\n");
+                    break;
+                default: break;
+            }
+        }
+        return out;
+    }
+
+    // The same output as MarkdownVisitor
+    inline string render_markdown(const FlatDocument& d)
+    {
+        string out;
+        out.reserve(d.text.size() + d.records.size() * 4);
+        for(auto& r : d.records)
+        {
+            switch(r.kind)
+            {
+                case FlatDocument::Kind::Paragraph:
+                    out.append(d.data(r), r.length).append("\n");
+                    break;
+                case FlatDocument::Kind::ListItem:
+                    out.append(" * ").append(d.data(r), r.length).append("\n");
+                    break;
+                default: break; // lists have no markers of their own in markdown
+            }
+        }
+        return out;
+    }
 }
 
 using namespace Visitor;
@@ -176,6 +492,96 @@ int Visitor_main(int argc, char* argv[])
 
     cout << v.str() << endl;
 
+    // Or send the output somewhere as it's rendered, without building the whole string first
+    StreamSink out{ cout };
+    StreamingMarkdownVisitor md{ out };
+    for(auto x : document)
+    {
+        x->accept(md);
+    }
+    md.flush();
+
+    getchar();
+    return EXIT_SUCCESS;
+}
+
+// A large document rendered through the visitors and from the flat layout
+int Visitor_Benchmark_main(int argc, char* argv[])
+{
+    vector<unique_ptr<Element>> elements;
+    for(int i = 0; i < 200000; ++i)
+    {
+        elements.push_back(make_unique<Paragraph>("Paragraph number " + to_string(i)));
+        elements.push_back(make_unique<List>(List{ ListItem{ "Red" }, ListItem{ "Green" }, ListItem{ "Blue" } }));
+    }
+
+    FlatteningVisitor flattener;
+    for(auto& x : elements)
+        x->accept(flattener);
+    const auto& flat = flattener.document;
+
+    const auto time = [](const string& name, auto render)
+    {
+        const auto start = chrono::steady_clock::now();
+        const auto out = render();
+        const chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+        cout << name << ": " << elapsed.count() << "ms, " << out.size() << " bytes" << endl;
+        return out;
+    };
+
+    const auto html = time("html visitor", [&]
+    {
+        HtmlVisitor v;
+        for(auto& x : elements)
+            x->accept(v);
+        return v.str();
+    });
+    const auto flat_html = time("html flat", [&] { return render_html(flat); });
+    cout << (html == flat_html ? "same output" : "OUTPUT DIFFERS") << endl;
+
+    vector<Element*> document;
+    for(auto& x : elements)
+        document.push_back(x.get());
+    const auto parallel_html = time("html parallel", [&] { return render_parallel<HtmlVisitor>(document); });
+    cout << (html == parallel_html ? "same output" : "OUTPUT DIFFERS") << endl;
+
+    const auto markdown = time("markdown visitor", [&]
+    {
+        MarkdownVisitor v;
+        for(auto x : document)
+            x->accept(v);
+        return v.str();
+    });
+    const auto parallel_markdown = time("markdown parallel", [&] { return render_parallel<MarkdownVisitor>(document); });
+    cout << (markdown == parallel_markdown ? "same output" : "OUTPUT DIFFERS") << endl;
+
+    time("markdown flat", [&] { return render_markdown(flat); });
+
+    // Streaming, how long until the first bytes could be sent, and is it the same output
+    struct TimingSink : Sink
+    {
+        chrono::steady_clock::time_point first;
+        string received;
+
+        void write(const char* data, size_t size) override
+        {
+            if(received.empty())
+                first = chrono::steady_clock::now();
+            received.append(data, size);
+        }
+    } sink;
+
+    const auto start = chrono::steady_clock::now();
+    {
+        StreamingHtmlVisitor v{ sink };
+        for(auto x : document)
+            x->accept(v);
+    }
+    const chrono::duration<double, milli> total = chrono::steady_clock::now() - start;
+    const chrono::duration<double, milli> first_byte = sink.first - start;
+    cout << "html streaming: " << total.count() << "ms, first chunk after " << first_byte.count() << "ms, "
+         << (sink.received == html ? "same output" : "OUTPUT DIFFERS") << endl;
+
     getchar();
     return EXIT_SUCCESS;
 }
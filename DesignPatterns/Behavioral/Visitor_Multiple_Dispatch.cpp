@@ -4,6 +4,18 @@
 #include <sstream>
 #include <typeindex>
 #include <map>
+#include <memory>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <array>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 using namespace std;
 
 
@@ -19,11 +31,44 @@ namespace Visitor_Multiple_Dispatch
     struct GameObject;
     void collide(GameObject& first, GameObject& second);
 
+    struct Planet;
+    struct Asteroid;
+    struct Spaceship;
+    struct ArmedSpaceship;
+
+    // Every type of game object, its position in this list is a small number we can index with
+    template <typename... Ts> struct TypeList {};
+    using GameObjectTypes = TypeList<Planet, Asteroid, Spaceship, ArmedSpaceship>;
+
+    template <typename List> struct Size;
+    template <typename... Ts>
+    struct Size<TypeList<Ts...>>
+    {
+        static constexpr size_t value = sizeof...(Ts);
+    };
+    constexpr size_t game_object_type_count = Size<GameObjectTypes>::value; // add a type and this follows
+
+    template <typename T, typename List> struct IndexOf;
+    template <typename T, typename... Ts>
+    struct IndexOf<T, TypeList<T, Ts...>>
+    {
+        static constexpr size_t value = 0;
+    };
+    template <typename T, typename U, typename... Ts>
+    struct IndexOf<T, TypeList<U, Ts...>>
+    {
+        static constexpr size_t value = 1 + IndexOf<T, TypeList<Ts...>>::value;
+    };
+
     // This is our base game object
     struct GameObject
     {
+        float x{ 0 }, y{ 0 }; // Where it is
+        float radius{ 1 };    // and a circle it fits inside, to know when it touches something
+
         virtual ~GameObject() = default;
         virtual type_index type() const = 0; // So we can identify the actual type
+        virtual size_t type_id() const = 0; // The same, as its position in GameObjectTypes
         virtual void collide(GameObject& other)
         {   // So we can call collide on the game object, which will just proxy over
             Visitor_Multiple_Dispatch::collide(*this, other);
@@ -38,6 +83,11 @@ namespace Visitor_Multiple_Dispatch
         {
             return typeid(T);
         }
+
+        size_t type_id() const override
+        {
+            return IndexOf<T, GameObjectTypes>::value; // worked out by the compiler
+        }
     };
 
     // We inherit from the template instead, they are still game objects
@@ -50,6 +100,11 @@ namespace Visitor_Multiple_Dispatch
         {
             return typeid(ArmedSpaceship);
         }
+
+        size_t type_id() const override
+        {
+            return IndexOf<ArmedSpaceship, GameObjectTypes>::value;
+        }
     };
 
     // Some outcomes that will happen on collisions
@@ -57,10 +112,12 @@ namespace Visitor_Multiple_Dispatch
     void asteroid_planet() { cout << "asteroid burns up in atmosphere\n"; }
     void asteroid_spaceship() { cout << "asteroid hits and destroys spaceship\n"; }
     void asteroid_armed_spaceship() { cout << "spaceship shoots asteroid\n"; }
+    void pass_harmlessly() { cout << "objects pass each other harmlessly\n"; }
 
     // Now we can map which function is called when two objects collide
     // ObjectA + ObjectB = FunctionC
-    map<pair<type_index, type_index>, void(*)(void)> outcomes{
+    using Outcomes = map<pair<type_index, type_index>, void(*)(void)>;
+    Outcomes outcomes{
         {{typeid(Spaceship), typeid(Planet)}, spaceship_planet},
         {{typeid(Asteroid), typeid(Planet)}, asteroid_planet},
         {{typeid(Asteroid), typeid(Spaceship)}, asteroid_spaceship},
@@ -68,7 +125,8 @@ namespace Visitor_Multiple_Dispatch
     };
 
     // We can search the map to find a corresponding function to call
-    void collide(GameObject& first, GameObject& second)
+    void collide(GameObject& first, GameObject& second, const Outcomes& outcomes,
+                 void (*otherwise)(void) = pass_harmlessly)
     {
         auto it = outcomes.find({first.type(), second.type()});
         if(it == outcomes.end())
@@ -77,12 +135,395 @@ namespace Visitor_Multiple_Dispatch
             it = outcomes.find({second.type(), first.type()});
             if(it == outcomes.end())
             {   // No collision function in map
-                cout << "objects pass each other harmlessly\n";
+                otherwise();
                 return;
             }
         }
         it->second(); // execute the function
     }
+
+    // Searching the map compares type_index values, up to twice per collision.
+    // As every type has a small number, the outcomes can go in a [type][type] table instead,
+    // filled in both ways round, so a collision is just one indexed call
+    class CollisionTable
+    {
+        void (*cells[game_object_type_count][game_object_type_count])(void);
+
+        template <typename... Ts>
+        static vector<type_index> types(TypeList<Ts...>)
+        {
+            return { typeid(Ts)... }; // in id order
+        }
+    public:
+        explicit CollisionTable(const Outcomes& outcomes, void (*otherwise)(void) = pass_harmlessly)
+        {
+            const auto ids = types(GameObjectTypes{});
+            for(size_t a = 0; a < game_object_type_count; ++a)
+            {
+                for(size_t b = 0; b < game_object_type_count; ++b)
+                {
+                    auto it = outcomes.find({ ids[a], ids[b] });
+                    if(it == outcomes.end())
+                        it = outcomes.find({ ids[b], ids[a] });
+                    cells[a][b] = it == outcomes.end() ? otherwise : it->second;
+                }
+            }
+        }
+
+        void operator()(GameObject& first, GameObject& second) const
+        {
+            cells[first.type_id()][second.type_id()]();
+        }
+    };
+
+    // Everyday collisions go through a table made from outcomes the first time one happens,
+    // so change outcomes before then. The map search above is still there to compare against
+    const CollisionTable& collision_table()
+    {
+        static const CollisionTable table{ outcomes };
+        return table;
+    }
+
+    void collide(GameObject& first, GameObject& second)
+    {
+        collision_table()(first, second);
+    }
+
+    // With lots of objects we can't try every pair, that's n*n/2 checks. The grid
+    // is the broad phase: objects go in square cells at least as wide as the biggest object,
+    // so anything touching an object is in its cell or one of the 8 around it.
+    // The cell size is worked out from the biggest radius every time the grid is rebuilt,
+    // so one big planet makes the cells big, but nothing is ever missed.
+    // Cells are hashed into buckets, so the world doesn't need a size
+    class SpatialGrid
+    {
+        float cell_size{ 1 };
+        vector<int32_t> heads;  // first object in each bucket, -1 if empty
+        vector<int32_t> next;   // next object in the same bucket
+        vector<pair<int32_t, int32_t>> cell_of;
+
+        size_t bucket(int32_t cx, int32_t cy) const
+        {
+            const auto h = static_cast<uint32_t>(cx) * 73856093u ^ static_cast<uint32_t>(cy) * 19349663u;
+            return h & (heads.size() - 1);
+        }
+    public:
+        // Calls near(j, i) once for every pair of objects in the same or neighbouring cells,
+        // they might be touching. x(i) and y(i) say where object i is, radius(i) how big it is
+        template <typename X, typename Y, typename Radius, typename Near>
+        void find_neighbours(size_t count, X x, Y y, Radius radius, Near near)
+        {
+            float biggest = 0;
+            for(int32_t i = 0; i < static_cast<int32_t>(count); ++i)
+                biggest = max(biggest, radius(i));
+            cell_size = biggest > 0 ? 2 * biggest : 1; // two objects touch when they're closer than that
+
+            size_t buckets = 16;
+            while(buckets < count * 2)
+                buckets *= 2;
+            heads.assign(buckets, -1);
+            next.resize(count);
+            cell_of.resize(count);
+
+            // Each object is checked against the ones already in the grid, then added,
+            // so every pair is only seen once
+            for(int32_t i = 0; i < static_cast<int32_t>(count); ++i)
+            {
+                const auto cx = static_cast<int32_t>(floor(x(i) / cell_size));
+                const auto cy = static_cast<int32_t>(floor(y(i) / cell_size));
+
+                for(int32_t ny = cy - 1; ny <= cy + 1; ++ny)
+                {
+                    for(int32_t nx = cx - 1; nx <= cx + 1; ++nx)
+                    {
+                        for(auto j = heads[bucket(nx, ny)]; j != -1; j = next[j])
+                        {
+                            if(cell_of[j] == make_pair(nx, ny)) // not another cell that hashed to the same bucket
+                                near(j, i);
+                        }
+                    }
+                }
+
+                cell_of[i] = { cx, cy };
+                auto& head = heads[bucket(cx, cy)];
+                next[i] = head;
+                head = i;
+            }
+        }
+
+        // Calls found(a, b) once for every pair of objects that overlap
+        template <typename Found>
+        void find_pairs(const vector<GameObject*>& objects, Found found)
+        {
+            find_neighbours(objects.size(),
+                [&](int32_t i) { return objects[i]->x; },
+                [&](int32_t i) { return objects[i]->y; },
+                [&](int32_t i) { return objects[i]->radius; },
+                [&](int32_t j, int32_t i)
+                {
+                    auto& a = *objects[i];
+                    auto& b = *objects[j];
+                    const auto dx = a.x - b.x, dy = a.y - b.y, reach = a.radius + b.radius;
+                    if(dx * dx + dy * dy < reach * reach)
+                        found(b, a);
+                });
+        }
+    };
+
+    // Threads that share out numbered chunks of work. Each worker starts with its own run
+    // of chunks, and when it runs out it steals from the other end of somebody else's
+    class WorkStealingPool
+    {
+        struct Queue
+        {
+            mutex mtx;
+            deque<size_t> chunks;
+        };
+        vector<unique_ptr<Queue>> queues;
+        vector<thread> threads;
+
+        mutex mtx;
+        condition_variable start, finished;
+        function<void(size_t, size_t)> job;
+        size_t generation = 0;
+        size_t busy = 0;
+        bool stopping = false;
+
+        bool next_chunk(size_t worker, size_t& chunk)
+        {
+            {
+                auto& own = *queues[worker];
+                lock_guard<mutex> lock{ own.mtx };
+                if(!own.chunks.empty())
+                {
+                    chunk = own.chunks.front();
+                    own.chunks.pop_front();
+                    return true;
+                }
+            }
+            for(size_t i = 1; i < queues.size(); ++i)
+            {
+                auto& other = *queues[(worker + i) % queues.size()];
+                lock_guard<mutex> lock{ other.mtx };
+                if(!other.chunks.empty())
+                {
+                    chunk = other.chunks.back();
+                    other.chunks.pop_back();
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void work(size_t worker)
+        {
+            size_t seen = 0;
+            for(;;)
+            {
+                {
+                    unique_lock<mutex> lock{ mtx };
+                    start.wait(lock, [&] { return stopping || generation != seen; });
+                    if(stopping)
+                        return;
+                    seen = generation;
+                }
+
+                size_t chunk;
+                while(next_chunk(worker, chunk))
+                    job(worker, chunk);
+
+                lock_guard<mutex> lock{ mtx };
+                if(--busy == 0)
+                    finished.notify_one();
+            }
+        }
+    public:
+        explicit WorkStealingPool(size_t workers)
+        {
+            for(size_t i = 0; i < workers; ++i)
+                queues.push_back(make_unique<Queue>());
+            for(size_t i = 0; i < workers; ++i)
+                threads.emplace_back([this, i] { work(i); });
+        }
+
+        ~WorkStealingPool()
+        {
+            {
+                lock_guard<mutex> lock{ mtx };
+                stopping = true;
+            }
+            start.notify_all();
+            for(auto& t : threads)
+                t.join();
+        }
+
+        size_t size() const
+        {
+            return queues.size();
+        }
+
+        // Calls fn(worker, chunk) for every chunk in [0, chunks), and waits for them all
+        void run(size_t chunks, function<void(size_t worker, size_t chunk)> fn)
+        {
+            for(size_t w = 0; w < queues.size(); ++w)
+            {
+                lock_guard<mutex> lock{ queues[w]->mtx };
+                for(size_t c = chunks * w / queues.size(); c < chunks * (w + 1) / queues.size(); ++c)
+                    queues[w]->chunks.push_back(c);
+            }
+
+            unique_lock<mutex> lock{ mtx };
+            job = move(fn);
+            busy = queues.size();
+            ++generation;
+            start.notify_all();
+            finished.wait(lock, [&] { return busy == 0; });
+        }
+    };
+
+    // Rather than a heap of GameObjects, the world keeps each type of object together,
+    // and each of their fields in its own column, so the collision code walks straight through memory.
+    // Objects are known by their type and their row in that type's columns
+    class GameWorld
+    {
+    public:
+        struct Handle
+        {
+            uint32_t type : 4;
+            uint32_t row : 28;
+        };
+
+        struct Contact
+        {
+            Handle first, second;
+            uint8_t outcome; // index into the world's outcome functions
+        };
+    private:
+        struct Columns
+        {
+            vector<float> x, y, radius;
+        };
+        array<Columns, game_object_type_count> by_type;
+
+        vector<void(*)(void)> outcome_functions;
+        uint8_t outcome_of[game_object_type_count][game_object_type_count];
+
+        SpatialGrid grid;
+        vector<Handle> handles;                  // everything, in one list for the grid
+        vector<pair<uint32_t, uint32_t>> candidates;
+
+        // Every worker writes the contacts it finds to its own buffer, and notes where
+        // each chunk's contacts went, so they can be put back in chunk order
+        struct Span
+        {
+            size_t worker, begin, end;
+        };
+        vector<vector<Contact>> buffers;
+        vector<Span> spans;
+        vector<Contact> contacts;
+
+        template <typename... Ts>
+        static vector<type_index> types(TypeList<Ts...>)
+        {
+            return { typeid(Ts)... };
+        }
+
+        const Columns& columns(Handle h) const
+        {
+            return by_type[h.type];
+        }
+    public:
+        GameWorld(const Outcomes& outcomes, void (*otherwise)(void) = pass_harmlessly)
+        {
+            outcome_functions.push_back(otherwise);
+            map<void(*)(void), uint8_t> numbered;
+            for(auto& o : outcomes)
+            {
+                if(numbered.emplace(o.second, static_cast<uint8_t>(outcome_functions.size())).second)
+                    outcome_functions.push_back(o.second);
+            }
+
+            const auto ids = types(GameObjectTypes{});
+            for(size_t a = 0; a < game_object_type_count; ++a)
+            {
+                for(size_t b = 0; b < game_object_type_count; ++b)
+                {
+                    auto it = outcomes.find({ ids[a], ids[b] });
+                    if(it == outcomes.end())
+                        it = outcomes.find({ ids[b], ids[a] });
+                    outcome_of[a][b] = it == outcomes.end() ? 0 : numbered[it->second];
+                }
+            }
+        }
+
+        template <typename T>
+        Handle add(float x, float y, float radius)
+        {
+            const auto type = IndexOf<T, GameObjectTypes>::value;
+            auto& c = by_type[type];
+            const Handle h{ static_cast<uint32_t>(type), static_cast<uint32_t>(c.x.size()) };
+            c.x.push_back(x);
+            c.y.push_back(y);
+            c.radius.push_back(radius);
+            return h;
+        }
+
+        size_t size() const
+        {
+            size_t total = 0;
+            for(auto& c : by_type)
+                total += c.x.size();
+            return total;
+        }
+
+        // One tick: the grid finds candidate pairs, the pool checks them in parallel,
+        // then the outcomes happen in the same order however many threads there were
+        const vector<Contact>& tick(WorkStealingPool& pool, size_t chunk_size = 4096)
+        {
+            handles.clear();
+            for(uint32_t type = 0; type < game_object_type_count; ++type)
+                for(uint32_t row = 0; row < by_type[type].x.size(); ++row)
+                    handles.push_back({ type, row });
+
+            candidates.clear();
+            grid.find_neighbours(handles.size(),
+                [&](int32_t i) { return columns(handles[i]).x[handles[i].row]; },
+                [&](int32_t i) { return columns(handles[i]).y[handles[i].row]; },
+                [&](int32_t i) { return columns(handles[i]).radius[handles[i].row]; },
+                [&](int32_t j, int32_t i) { candidates.emplace_back(j, i); });
+
+            const auto chunks = (candidates.size() + chunk_size - 1) / chunk_size;
+            buffers.resize(pool.size());
+            for(auto& b : buffers)
+                b.clear();
+            spans.resize(chunks);
+
+            pool.run(chunks, [&](size_t worker, size_t chunk)
+            {
+                auto& out = buffers[worker];
+                const auto begin = out.size();
+                const auto last = min(candidates.size(), (chunk + 1) * chunk_size);
+                for(auto i = chunk * chunk_size; i < last; ++i)
+                {
+                    const auto a = handles[candidates[i].first], b = handles[candidates[i].second];
+                    const auto& ca = columns(a);
+                    const auto& cb = columns(b);
+                    const auto dx = ca.x[a.row] - cb.x[b.row], dy = ca.y[a.row] - cb.y[b.row];
+                    const auto reach = ca.radius[a.row] + cb.radius[b.row];
+                    if(dx * dx + dy * dy < reach * reach)
+                        out.push_back({ a, b, outcome_of[a.type][b.type] });
+                }
+                spans[chunk] = { worker, begin, out.size() };
+            });
+
+            contacts.clear();
+            for(auto& s : spans)
+                contacts.insert(contacts.end(), buffers[s.worker].begin() + s.begin, buffers[s.worker].begin() + s.end);
+            for(auto& c : contacts)
+                outcome_functions[c.outcome]();
+            return contacts;
+        }
+    };
 }
 
 using namespace Visitor_Multiple_Dispatch;
@@ -100,6 +541,224 @@ int Visitor_Multiple_Dispatch_main(int argc, char* argv[])
     planet.collide(planet); // We can call collide on the object too
 
 
+    getchar();
+    return EXIT_SUCCESS;
+}
+
+// Count the outcomes rather than printing them, so we only time finding them
+size_t outcome_counts[5];
+template <int I> void counted() { ++outcome_counts[I]; }
+
+int Visitor_Multiple_Dispatch_Benchmark_main(int argc, char* argv[])
+{
+    const Outcomes counting{
+        {{typeid(Spaceship), typeid(Planet)}, counted<0>},
+        {{typeid(Asteroid), typeid(Planet)}, counted<1>},
+        {{typeid(Asteroid), typeid(Spaceship)}, counted<2>},
+        {{typeid(Asteroid), typeid(ArmedSpaceship)}, counted<3>},
+    };
+    const CollisionTable table{ counting, counted<4> };
+
+    Planet planet;
+    Asteroid asteroid;
+    Spaceship spaceship;
+    ArmedSpaceship armed;
+    GameObject* objects[]{ &planet, &asteroid, &spaceship, &armed };
+
+    const size_t collisions = 10000000;
+    mt19937 rng{ 42 };
+    uniform_int_distribution<int> pick{ 0, 3 };
+    vector<pair<GameObject*, GameObject*>> pairs(collisions);
+    for(auto& p : pairs)
+        p = { objects[pick(rng)], objects[pick(rng)] };
+
+    const auto run = [&](const string& name, auto dispatch)
+    {
+        fill(begin(outcome_counts), end(outcome_counts), 0);
+        const auto start = chrono::steady_clock::now();
+        for(auto& p : pairs)
+            dispatch(*p.first, *p.second);
+        const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+        cout << name << ": " << elapsed.count() * 1e9 / collisions << "ns/collision, outcomes";
+        for(auto c : outcome_counts)
+            cout << " " << c;
+        cout << endl;
+    };
+
+    run("map", [&](GameObject& a, GameObject& b) { collide(a, b, counting, counted<4>); });
+    run("table", [&](GameObject& a, GameObject& b) { table(a, b); });
+
+    getchar();
+    return EXIT_SUCCESS;
+}
+
+// A frame of a big game, the grid finds who is touching and only they collide
+int Visitor_Multiple_Dispatch_BroadPhase_main(int argc, char* argv[])
+{
+    const Outcomes counting{
+        {{typeid(Spaceship), typeid(Planet)}, counted<0>},
+        {{typeid(Asteroid), typeid(Planet)}, counted<1>},
+        {{typeid(Asteroid), typeid(Spaceship)}, counted<2>},
+        {{typeid(Asteroid), typeid(ArmedSpaceship)}, counted<3>},
+    };
+    const CollisionTable table{ counting, counted<4> };
+
+    const auto make_world = [](size_t count, float size)
+    {
+        mt19937 rng{ 7 };
+        uniform_real_distribution<float> where{ 0, size };
+        uniform_real_distribution<float> how_big{ 0.5f, 2.0f };
+        vector<unique_ptr<GameObject>> world;
+        for(size_t i = 0; i < count; ++i)
+        {
+            switch(i % 4)
+            {
+            case 0: world.push_back(make_unique<Planet>()); break;
+            case 1: world.push_back(make_unique<Asteroid>()); break;
+            case 2: world.push_back(make_unique<Spaceship>()); break;
+            default: world.push_back(make_unique<ArmedSpaceship>()); break;
+            }
+            world.back()->x = where(rng);
+            world.back()->y = where(rng);
+            world.back()->radius = how_big(rng);
+        }
+        return world;
+    };
+    const auto pointers = [](const vector<unique_ptr<GameObject>>& world)
+    {
+        vector<GameObject*> objects;
+        for(auto& o : world)
+            objects.push_back(o.get());
+        return objects;
+    };
+
+    // First make sure the grid finds the same pairs as checking every pair does
+    {
+        const auto world = make_world(5000, 300);
+        const auto objects = pointers(world);
+        size_t every_pair = 0, grid = 0;
+        for(size_t i = 0; i < objects.size(); ++i)
+        {
+            for(size_t j = i + 1; j < objects.size(); ++j)
+            {
+                const auto dx = objects[i]->x - objects[j]->x, dy = objects[i]->y - objects[j]->y;
+                const auto reach = objects[i]->radius + objects[j]->radius;
+                if(dx * dx + dy * dy < reach * reach)
+                    ++every_pair;
+            }
+        }
+        SpatialGrid{}.find_pairs(objects, [&](GameObject&, GameObject&) { ++grid; });
+        cout << "5000 objects, every pair finds " << every_pair << " contacts, grid finds " << grid << endl;
+    }
+
+    // The cells grow to fit the biggest object, so a planet much bigger than the rest is still found
+    {
+        Planet planet;
+        Asteroid asteroid;
+        planet.radius = 50;
+        asteroid.x = 30;
+        size_t grid = 0;
+        SpatialGrid{}.find_pairs({ &planet, &asteroid }, [&](GameObject&, GameObject&) { ++grid; });
+        cout << "a big planet and an asteroid 30 away, grid finds " << grid << " contact" << endl;
+    }
+
+    const auto world = make_world(100000, 3000);
+    const auto objects = pointers(world);
+    SpatialGrid grid;
+    const size_t frames = 20;
+
+    fill(begin(outcome_counts), end(outcome_counts), 0);
+    size_t contacts = 0;
+    const auto start = chrono::steady_clock::now();
+    for(size_t frame = 0; frame < frames; ++frame)
+    {
+        grid.find_pairs(objects, [&](GameObject& a, GameObject& b)
+        {
+            ++contacts;
+            table(a, b);
+        });
+    }
+    const chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+
+    cout << objects.size() << " objects: " << elapsed.count() / frames << "ms/frame, "
+         << contacts / frames << " contacts/frame, outcomes";
+    for(auto c : outcome_counts)
+        cout << " " << c / frames;
+    cout << endl;
+
+    getchar();
+    return EXIT_SUCCESS;
+}
+
+// The same sort of frame, with the world stored by type and the pairs checked on several threads
+int Visitor_Multiple_Dispatch_World_main(int argc, char* argv[])
+{
+    const Outcomes counting{
+        {{typeid(Spaceship), typeid(Planet)}, counted<0>},
+        {{typeid(Asteroid), typeid(Planet)}, counted<1>},
+        {{typeid(Asteroid), typeid(Spaceship)}, counted<2>},
+        {{typeid(Asteroid), typeid(ArmedSpaceship)}, counted<3>},
+    };
+
+    GameWorld world{ counting, counted<4> };
+    mt19937 rng{ 7 };
+    uniform_real_distribution<float> where{ 0, 3000 };
+    uniform_real_distribution<float> how_big{ 0.5f, 2.0f };
+    for(size_t i = 0; i < 100000; ++i)
+    {
+        const auto x = where(rng), y = where(rng), radius = how_big(rng);
+        switch(i % 4)
+        {
+        case 0: world.add<Planet>(x, y, radius); break;
+        case 1: world.add<Asteroid>(x, y, radius); break;
+        case 2: world.add<Spaceship>(x, y, radius); break;
+        default: world.add<ArmedSpaceship>(x, y, radius); break;
+        }
+    }
+
+    // The grid sizes its cells every tick, so a planet much bigger than the rest is still found
+    {
+        GameWorld big{ counting, counted<4> };
+        big.add<Planet>(0, 0, 50);
+        big.add<Asteroid>(30, 0, 1);
+        WorkStealingPool pool{ 1 };
+        cout << "a big planet and an asteroid 30 away, " << big.tick(pool).size() << " contact" << endl;
+    }
+
+    const size_t frames = 20;
+    vector<pair<uint32_t, uint32_t>> single_threaded; // to check more threads find the same, in the same order
+    for(size_t threads : { size_t{ 1 }, size_t{ 2 }, size_t{ 4 }, size_t{ thread::hardware_concurrency() } })
+    {
+        WorkStealingPool pool{ max<size_t>(threads, 1) };
+        fill(begin(outcome_counts), end(outcome_counts), 0);
+        size_t contacts = 0;
+        bool same = true;
+
+        const auto start = chrono::steady_clock::now();
+        for(size_t frame = 0; frame < frames; ++frame)
+        {
+            const auto& found = world.tick(pool);
+            contacts += found.size();
+            if(frame == 0)
+            {
+                vector<pair<uint32_t, uint32_t>> order;
+                for(auto& c : found)
+                    order.emplace_back(c.first.type << 28 | c.first.row, c.second.type << 28 | c.second.row);
+                if(single_threaded.empty())
+                    single_threaded = order;
+                same = order == single_threaded;
+            }
+        }
+        const chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+
+        cout << pool.size() << " thread(s): " << elapsed.count() / frames << "ms/frame, "
+             << contacts / frames << " contacts/frame, outcomes";
+        for(auto c : outcome_counts)
+            cout << " " << c / frames;
+        cout << (same ? "" : " (different order!)") << endl;
+    }
+
     getchar();
     return EXIT_SUCCESS;
 }